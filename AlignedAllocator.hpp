@@ -0,0 +1,54 @@
+#ifndef ALIGNED_ALLOCATOR_HPP
+#define ALIGNED_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+template<typename T, std::size_t Alignment = 64>
+struct AlignedAllocator
+{
+    typedef T value_type;
+
+    template<typename U>
+    struct rebind
+    {
+        typedef AlignedAllocator<U, Alignment> other;
+    };
+
+    AlignedAllocator() {}
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+    T* allocate(std::size_t count)
+    {
+        void *block = ::operator new(count*sizeof(T) + Alignment);
+        std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(block) + Alignment) & ~std::uintptr_t(Alignment - 1);
+        reinterpret_cast<void **>(aligned)[-1] = block;
+        return reinterpret_cast<T *>(aligned);
+    }
+
+    void deallocate(T *pointer, std::size_t)
+    {
+        if(pointer)
+            ::operator delete(reinterpret_cast<void **>(pointer)[-1]);
+    }
+};
+
+template<typename T, typename U, std::size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment> &, const AlignedAllocator<U, Alignment> &)
+{
+    return true;
+}
+
+template<typename T, typename U, std::size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment> &, const AlignedAllocator<U, Alignment> &)
+{
+    return false;
+}
+
+template<typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+#endif
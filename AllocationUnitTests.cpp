@@ -0,0 +1,291 @@
+#include "gtest/gtest.h"
+#include "BallPhysics.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Every heap allocation in this test binary goes through the hooks below.
+// They only count while a test has switched counting on. On glibc malloc
+// itself is interposed, which also catches C allocations; sanitizers bring
+// their own malloc, so they only get the operator new hooks.
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define ALLOCATION_TESTS_HOOK_MALLOC
+#endif
+
+
+namespace
+{
+std::atomic<bool> countingAllocations{false};
+std::atomic<unsigned long> allocationCount{0};
+
+void note_allocation()
+{
+    if(countingAllocations.load(std::memory_order_relaxed))
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* allocate(std::size_t size)
+{
+#ifndef ALLOCATION_TESTS_HOOK_MALLOC
+    note_allocation();
+#endif
+    return std::malloc(size > 0 ? size : 1);
+}
+}
+
+#ifdef ALLOCATION_TESTS_HOOK_MALLOC
+extern "C" void* __libc_malloc(std::size_t size);
+extern "C" void* __libc_calloc(std::size_t count, std::size_t size);
+extern "C" void* __libc_realloc(void *block, std::size_t size);
+
+extern "C" void* malloc(std::size_t size) noexcept
+{
+    note_allocation();
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(std::size_t count, std::size_t size) noexcept
+{
+    note_allocation();
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void *block, std::size_t size) noexcept
+{
+    note_allocation();
+    return __libc_realloc(block, size);
+}
+#endif
+
+void* operator new(std::size_t size)
+{
+    void *block{allocate(size)};
+    if(!block)
+        throw std::bad_alloc();
+    return block;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+// Once these are inlined GCC sees free() paired with operator new and
+// warns, not knowing the new above hands out malloc'd blocks.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void *block) noexcept
+{
+    std::free(block);
+}
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+
+class AllocationTests : public ::testing::Test
+{
+protected:
+    void start_counting();
+    unsigned long stop_counting();
+    void fill_fountain(BallPhysics &fountain);
+
+    unsigned int warmUpSteps{600};
+    unsigned int countedSteps{2000};
+    float stepTime{1.0/120};
+};
+
+void AllocationTests::start_counting()
+{
+    allocationCount = 0;
+    countingAllocations = true;
+}
+
+unsigned long AllocationTests::stop_counting()
+{
+    countingAllocations = false;
+    return allocationCount;
+}
+
+// A full simulator fed by a busy emitter, so every step recycles balls.
+void AllocationTests::fill_fountain(BallPhysics &fountain)
+{
+    Emitter nozzle(Eigen::Vector3f{0, 0, 0.5}, Eigen::Vector3f{0, 0, 1}, 15, 400);
+    nozzle.set_spread_angle(0.3);
+    fountain.add_emitter(nozzle);
+    for(unsigned int step{0}; step < warmUpSteps; step++)
+        fountain.update(stepTime);
+}
+
+volatile void *observedBlock{nullptr};
+
+TEST_F(AllocationTests, WhenAllocatingWhileCounting_ExpectAllocationSeen)
+{
+    start_counting();
+    int *block = new int(1);
+    observedBlock = block;
+    unsigned long count{stop_counting()};
+    delete block;
+
+    EXPECT_GE(count, 1);
+}
+
+TEST_F(AllocationTests, WhenSteppingFullFountainAfterWarmUp_ExpectNoAllocations)
+{
+    BallPhysics fountain(10, 1.2, -9.81, 300);
+    fill_fountain(fountain);
+
+    start_counting();
+    for(unsigned int step{0}; step < countedSteps; step++)
+        fountain.update(stepTime);
+    unsigned long count{stop_counting()};
+
+    EXPECT_EQ(fountain.get_ball_count(), 300);
+    EXPECT_EQ(count, 0);
+}
+
+TEST_F(AllocationTests, WhenSteppingFullFountainWithThreadsAfterWarmUp_ExpectNoAllocations)
+{
+    BallPhysics fountain(10, 1.2, -9.81, 1500);
+    fountain.set_thread_count(4);
+    fill_fountain(fountain);
+    fill_fountain(fountain);
+
+    start_counting();
+    for(unsigned int step{0}; step < countedSteps; step++)
+        fountain.update(stepTime);
+    unsigned long count{stop_counting()};
+
+    EXPECT_EQ(count, 0);
+}
+
+TEST_F(AllocationTests, WhenSteppingFullFountainWithImpulseSolverAndThreads_ExpectNoAllocations)
+{
+    BallPhysics fountain(10, 1.2, -9.81, 1500);
+    fountain.set_collision_solver_type(impulseSolver);
+    fountain.set_thread_count(4);
+    fill_fountain(fountain);
+    fill_fountain(fountain);
+
+    start_counting();
+    for(unsigned int step{0}; step < countedSteps; step++)
+        fountain.update(stepTime);
+    unsigned long count{stop_counting()};
+
+    EXPECT_GT(fountain.get_contact_solver_ptr()->get_contact_count(), 0);
+    EXPECT_EQ(count, 0);
+}
+
+TEST_F(AllocationTests, WhenSteppingFullFountainWithContinuousCollision_ExpectNoAllocations)
+{
+    BallPhysics fountain(10, 1.2, -9.81, 1500);
+    fountain.set_continuous_collision_enabled(true);
+    fountain.get_continuous_collision_ptr()->set_motion_fraction(0.05);
+    fill_fountain(fountain);
+    fill_fountain(fountain);
+
+    unsigned long sweptCount{0};
+    start_counting();
+    for(unsigned int step{0}; step < countedSteps; step++)
+    {
+        fountain.update(stepTime);
+        sweptCount += fountain.get_continuous_collision_ptr()->get_swept_ball_count();
+    }
+    unsigned long count{stop_counting()};
+
+    EXPECT_GT(sweptCount, 0);
+    EXPECT_EQ(count, 0);
+}
+
+TEST_F(AllocationTests, WhenPublishingSnapshotsAfterWarmUp_ExpectNoAllocations)
+{
+    BallPhysics fountain(10, 0, -9.81, 300);
+    fill_fountain(fountain);
+    fountain.publish_snapshot();
+
+    start_counting();
+    for(unsigned int step{0}; step < countedSteps; step++)
+    {
+        fountain.update(stepTime);
+        fountain.publish_snapshot();
+        fountain.get_snapshot_buffer()->acquire_latest();
+    }
+    unsigned long count{stop_counting()};
+
+    EXPECT_EQ(count, 0);
+}
+
+TEST_F(AllocationTests, WhenAddingBallsInRingReplaceMode_ExpectNoAllocations)
+{
+    BallPhysics fountain(10, 0, -9.81, 1000);
+    for(unsigned int ballIndex{0}; ballIndex < fountain.get_max_ball_count(); ballIndex++)
+        fountain.add_ball();
+
+    start_counting();
+    for(unsigned int ballIndex{0}; ballIndex < countedSteps; ballIndex++)
+        fountain.add_ball();
+    unsigned long count{stop_counting()};
+
+    EXPECT_EQ(count, 0);
+}
+
+TEST_F(AllocationTests, WhenPileFallsAsleepAndIsWoken_ExpectNoAllocations)
+{
+    BallPhysics pile(10, 0, -9.81, 400);
+    pile.set_new_ball_velocity(Eigen::Vector3f{0, 0, 0});
+    for(unsigned int ballIndex{0}; ballIndex < pile.get_max_ball_count(); ballIndex++)
+    {
+        pile.set_new_ball_position(Eigen::Vector3f{float(ballIndex%10) - 5, float((ballIndex/10)%10) - 5, 0.5f + ballIndex/100});
+        pile.add_ball();
+    }
+    for(unsigned int step{0}; step < warmUpSteps; step++)
+        pile.update(stepTime);
+    pile.set_gravity(-9.8);
+
+    start_counting();
+    for(unsigned int step{0}; step < countedSteps; step++)
+    {
+        if(step == countedSteps/2)
+            pile.set_gravity(-9.81);
+        pile.update(stepTime);
+    }
+    unsigned long count{stop_counting()};
+
+    EXPECT_EQ(pile.get_awake_ball_count(), 0);
+    EXPECT_EQ(count, 0);
+}
+
+TEST_F(AllocationTests, WhenTracingFullFountainWithThreads_ExpectNoAllocations)
+{
+    BallPhysics fountain(10, 1.2, -9.81, 1500);
+    fountain.set_thread_count(4);
+    fill_fountain(fountain);
+    frametracer::start();
+    fountain.update(stepTime);
+
+    start_counting();
+    for(unsigned int step{0}; step < countedSteps/4; step++)
+        fountain.update(stepTime);
+    unsigned long count{stop_counting()};
+    frametracer::stop();
+
+    EXPECT_GT(frametracer::get_event_count(), countedSteps/4);
+    EXPECT_EQ(count, 0);
+}
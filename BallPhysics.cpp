@@ -1,123 +1,869 @@
 #include "BallPhysics.hpp"
+#include <cstring>
 
 
-BallPhysics::BallPhysics(float boxBoundSizeInput, float fluidDensityInput, float gravityInput): boxBoundSize{boxBoundSizeInput}, fluidDensity{fluidDensityInput}, gravity{gravityInput}
+bool operator==(const BallHandle &first, const BallHandle &second)
 {
+    return first.slot == second.slot && first.generation == second.generation;
 }
 
-void BallPhysics::add_ball()
+bool operator!=(const BallHandle &first, const BallHandle &second)
 {
-    float velocityMagnitude{newBallVelocity.norm()};
-    Eigen::Vector3f dragForce{Eigen::Vector3f{0.0, 0.0, 0.0}};
-    if(velocityMagnitude > 0)
-        dragForce = -(0.5*fluidDensity*pow(velocityMagnitude, 2)*dragCoefficient*(M_PI*pow(newBallRadius, 2)))/newBallMass*newBallVelocity/velocityMagnitude;
+    return !(first == second);
+}
+
+std::size_t BallPhysicsState::get_memory_size() const
+{
+    std::size_t ballBytes{(scenefile::floatArrayCount + scenefile::integerArrayCount)*balls.positionX.capacity()*sizeof(float)};
+    std::size_t slotBytes{(slotGenerations.capacity() + slotIndices.capacity() + slotOlder.capacity() + slotNewer.capacity() + freeSlots.capacity() + ballSlots.capacity() + slotIslandParent.capacity() + slotIslandNext.capacity())*sizeof(unsigned int)};
+    return sizeof(BallPhysicsState) + ballBytes + slotBytes + emitters.capacity()*sizeof(Emitter) + contactCache.capacity()*sizeof(CachedContact);
+}
+
+const unsigned int BallPhysics::noSlot;
+
+BallPhysics::BallPhysics(float boxBoundSizeInput, float fluidDensityInput, float gravityInput, unsigned int maxBallCountInput): boxBoundSize{boxBoundSizeInput}, fluidDensity{fluidDensityInput}, gravity{gravityInput}, maxBallCount{maxBallCountInput}
+{
+    balls.reserve(maxBallCount);
+    reserve_slots(maxBallCount);
+    reserve_step_buffers(maxBallCount);
+    snapshots->reserve(maxBallCount);
+}
+
+BallHandle BallPhysics::add_ball()
+{
+    BallHandle handle{noSlot, 0};
+    add_balls(1, nullptr, &handle);
+    return handle;
+}
+
+// Spawns a batch from the new-ball parameters. spawnAges[i] is how long ago
+// ball i left the nozzle within the current step.
+unsigned int BallPhysics::add_balls(unsigned int count, const float *spawnAges, BallHandle *handles)
+{
+    balls.reserve(std::min(ballCount + count, maxBallCount));
+    for(unsigned int spawnIndex{0}; spawnIndex < count; spawnIndex++)
+    {
+        Ball newBall(newBallRadius, newBallMass, newBallColor, newBallPosition, newBallVelocity, Eigen::Vector3f{0.0, 0.0, 0.0}, newBallCoefficientOfRestitution);
+        BallHandle handle{launch_ball(newBall, spawnAges ? spawnAges[spawnIndex] : 0)};
+        if(handles)
+            handles[spawnIndex] = handle;
+    }
+    return count;
+}
+
+// Services every registered emitter in one pass for a step of deltaTime.
+unsigned int BallPhysics::emit_balls(float deltaTime)
+{
+    PROFILE_PHASE(phaseprofiler::emission);
+    TRACE_SCOPE("BallPhysics::emit_balls");
+    unsigned int spawnedCount{0};
+    for(Emitter &emitter : emitters)
+    {
+        unsigned int count{emitter.advance(deltaTime)};
+        for(unsigned int spawnIndex{0}; spawnIndex < count; spawnIndex++)
+            launch_ball(emitter.sample_ball(), emitter.get_spawn_age(spawnIndex, count));
+        spawnedCount += count;
+    }
+    return spawnedCount;
+}
 
-    Eigen::Vector3f newBallAcceleration{Eigen::Vector3f{0.0, 0.0, gravity} + dragForce};
+// The ball is advanced along its launch trajectory by spawnAge so that a
+// dense jet comes out evenly spaced instead of clumped at the nozzle.
+BallHandle BallPhysics::launch_ball(Ball newBall, float spawnAge)
+{
+    float inverseMass{newBall.mass > 0 ? 1/newBall.mass : 0};
+    float newDragConstant{compute_drag_constant(newBall.radius, inverseMass)};
+    newBall.acceleration = Eigen::Vector3f{0.0, 0.0, gravity} - newDragConstant*newBall.velocity.norm()*newBall.velocity;
+    newBall.position += newBall.velocity*spawnAge + 0.5*newBall.acceleration*spawnAge*spawnAge;
+    newBall.velocity += newBall.acceleration*spawnAge;
+    return spawn_ball(newBall, newDragConstant);
+}
+
+BallHandle BallPhysics::spawn_ball(const Ball &newBall, float newDragConstant)
+{
+    unsigned int slot{noSlot};
+    unsigned int index{0};
     if(ballCount < maxBallCount)
     {
-        Ball newBall(newBallRadius, newBallMass, newBallColor, newBallPosition, newBallVelocity, newBallAcceleration, newBallCoefficientOfRestitution);
         this->balls.push_back(newBall);
         this->ballCount++;
+        index = ballCount - 1;
+        slot = allocate_slot();
+        slotIndices[slot] = index;
+        ballSlots.push_back(slot);
+        swap_balls(index, awakeCount);
+        index = awakeCount++;
     }
     else
     {
-        update_ball(ballReplaceIndex, newBallAcceleration);
-        if(ballReplaceIndex < maxBallCount)
-            ballReplaceIndex++;
-        else
-            ballReplaceIndex = 0;
+        slot = oldestSlot;
+        if(slotIndices[slot] >= awakeCount)
+            wake_island(slot);
+        unlink_slot(slot);
+        slotGenerations[slot]++;
+        index = slotIndices[slot];
+        balls.set(index, newBall);
     }
+    balls.dragConstant[index] = newDragConstant;
+    balls.revision[index] = ++revisionCounter;
+    link_newest_slot(slot);
+    return BallHandle{slot, slotGenerations[slot]};
 }
 
 void BallPhysics::update(float deltaTime)
 {
-    for(int ballIndex{0}; ballIndex < ballCount; ballIndex++)
+    TRACE_SCOPE("BallPhysics::update");
+    unsigned int taskCount{(awakeCount + ballsPerTask - 1)/ballsPerTask};
+    threadPool->parallel_for(taskCount, [this, deltaTime](unsigned int taskIndex)
     {
-        Ball &ball = balls[ballIndex];
-        float velocityMagnitude = ball.velocity.norm();
-        Eigen::Vector3f dragForce = Eigen::Vector3f{0.0, 0.0, 0.0};;
-        if(velocityMagnitude > 0)
-            dragForce = -(0.5*fluidDensity*pow(velocityMagnitude, 2)*dragCoefficient*(M_PI*pow(ball.radius, 2)))/ball.mass*ball.velocity/velocityMagnitude;
-        ball.acceleration = Eigen::Vector3f{0.0, 0.0, gravity} + dragForce;
-        ball.velocity = ball.velocity + ball.acceleration*deltaTime;
-        ball.position = ball.position + ball.velocity*deltaTime + 0.5*ball.acceleration*pow(deltaTime, 2);
-        update_box_collisions(ball);
-        update_ball_collisions(ball, ballIndex);
+        unsigned int firstIndex{taskIndex*ballsPerTask};
+        integrate_balls(firstIndex, std::min(firstIndex + ballsPerTask, awakeCount), deltaTime);
+    });
+    if(continuousCollisionEnabled)
+        update_continuous_collisions();
+    update_ball_collisions(deltaTime);
+    if(sleepingEnabled)
+        update_sleep_states(deltaTime);
+    emit_balls(deltaTime);
+    stepCount++;
+    if(trajectoryRecorder)
+        trajectoryRecorder->record(balls, ballSlots.data(), ballCount, stepCount);
+}
+
+void BallPhysics::integrate_balls(unsigned int firstIndex, unsigned int lastIndex, float deltaTime)
+{
+    TRACE_SCOPE("BallPhysics::integrate_balls");
+    {
+        PROFILE_PHASE(phaseprofiler::integration);
+        balls.store_previous_positions(firstIndex, lastIndex);
+        integrate(balls, firstIndex, lastIndex, gravity, deltaTime);
     }
+    if(collisionSolverType == impulseSolver)
+        return;
+    PROFILE_PHASE(phaseprofiler::boxCollisions);
+    for(unsigned int ballIndex{firstIndex}; ballIndex < lastIndex; ballIndex++)
+    {
+        if(!continuousCollisionEnabled || !continuousCollision.is_fast(balls, ballIndex))
+            update_box_collisions(ballIndex);
+    }
+}
+
+float BallPhysics::compute_drag_constant(float radius, float inverseMass)
+{
+    return 0.5*fluidDensity*dragCoefficient*M_PI*radius*radius*inverseMass;
+}
+
+void BallPhysics::refresh_drag_constants()
+{
+    for(unsigned int ballIndex{0}; ballIndex < ballCount; ballIndex++)
+        balls.dragConstant[ballIndex] = compute_drag_constant(balls.radius[ballIndex], balls.inverseMass[ballIndex]);
 }
 
 void BallPhysics::update_ball(unsigned int &index, Eigen::Vector3f &newBallAcceleration)
 {
-    if(this->ballCount >= index)
+    if(index < this->ballCount)
     {
-        this->balls[index].radius = newBallRadius;
-        this->balls[index].mass = newBallMass;
-        this->balls[index].color = newBallColor;
-        this->balls[index].position = newBallPosition;
-        this->balls[index].velocity = newBallVelocity;
-        this->balls[index].acceleration = newBallAcceleration;
-        this->balls[index].coefficientOfRestitution = newBallCoefficientOfRestitution;
+        if(index >= awakeCount)
+        {
+            unsigned int slot{ballSlots[index]};
+            wake_island(slot);
+            index = slotIndices[slot];
+        }
+        Ball newBall(newBallRadius, newBallMass, newBallColor, newBallPosition, newBallVelocity, newBallAcceleration, newBallCoefficientOfRestitution);
+        this->balls.set(index, newBall);
+        balls.dragConstant[index] = compute_drag_constant(balls.radius[index], balls.inverseMass[index]);
+        balls.revision[index] = ++revisionCounter;
     }
 }
 
 void BallPhysics::remove_ball()
 {
     if(this->ballCount > 0)
+        remove_ball(get_ball_handle(ballCount - 1));
+}
+
+// Swap-and-pop: the last awake ball moves into the hole and the last
+// sleeping ball into its place, so storage stays dense and partitioned.
+// Removing a sleeping ball wakes its island, since it may be holding it up.
+bool BallPhysics::remove_ball(BallHandle handle)
+{
+    int index{lookup(handle)};
+    if(index < 0)
+        return false;
+
+    if(unsigned(index) >= awakeCount)
     {
-        balls.pop_back();
-        ballCount--;
+        wake_island(handle.slot);
+        index = slotIndices[handle.slot];
     }
+    awakeCount--;
+    swap_balls(index, awakeCount);
+    swap_balls(awakeCount, ballCount - 1);
+    balls.pop_back();
+    ballSlots.pop_back();
+    ballCount--;
+
+    unlink_slot(handle.slot);
+    slotGenerations[handle.slot]++;
+    freeSlots.push_back(handle.slot);
+    return true;
+}
+
+int BallPhysics::lookup(BallHandle handle)
+{
+    if(handle.slot >= slotGenerations.size() || slotGenerations[handle.slot] != handle.generation)
+        return -1;
+    return slotIndices[handle.slot];
+}
+
+BallHandle BallPhysics::get_ball_handle(unsigned int index)
+{
+    unsigned int slot{ballSlots[index]};
+    return BallHandle{slot, slotGenerations[slot]};
 }
 
 void BallPhysics::clear_balls()
 {
-    balls.clear();
-    ballCount = 0;
+    wake_balls();
+    while(ballCount > 0)
+        remove_ball();
+    contactSolver.clear_cache();
+}
+
+// The sleeping balls are already at the back of storage, so waking all of
+// them only resets their island links.
+void BallPhysics::wake_balls()
+{
+    for(unsigned int ballIndex{awakeCount}; ballIndex < ballCount; ballIndex++)
+    {
+        unsigned int slot{ballSlots[ballIndex]};
+        slotIslandParent[slot] = slot;
+        slotIslandNext[slot] = slot;
+        balls.sleepTime[ballIndex] = 0;
+    }
+    awakeCount = ballCount;
+}
+
+void BallPhysics::reserve_slots(unsigned int capacity)
+{
+    slotGenerations.reserve(capacity);
+    slotIndices.reserve(capacity);
+    slotOlder.reserve(capacity);
+    slotNewer.reserve(capacity);
+    freeSlots.reserve(capacity);
+    ballSlots.reserve(capacity);
+    slotIslandParent.reserve(capacity);
+    slotIslandNext.reserve(capacity);
+}
+
+// Everything update() writes into is sized here for capacity balls so a
+// steady-state step never touches the heap. Pair lists can still grow past
+// the reserve in unusually dense piles; they keep their high-water capacity.
+void BallPhysics::reserve_step_buffers(unsigned int capacity)
+{
+    broadphase->reserve(capacity);
+    collisionPairs.reserve(capacity*reservedPairsPerBall);
+    coloredPairs.reserve(capacity*reservedPairsPerBall);
+    pairColors.reserve(capacity*reservedPairsPerBall);
+    ballNextColor.reserve(capacity);
+    islandParent.reserve(capacity);
+    islandQuiet.reserve(capacity);
+    sleepingContacts.reserve(capacity);
+    sleepingSlots.reserve(capacity);
+    wakeSlots.reserve(capacity);
+    contactSolver.reserve(capacity, capacity*reservedPairsPerBall);
+    continuousCollision.reserve(capacity);
+}
+
+unsigned int BallPhysics::allocate_slot()
+{
+    if(!freeSlots.empty())
+    {
+        unsigned int slot{freeSlots.back()};
+        freeSlots.pop_back();
+        return slot;
+    }
+    slotGenerations.push_back(1);
+    slotIndices.push_back(0);
+    slotOlder.push_back(noSlot);
+    slotNewer.push_back(noSlot);
+    slotIslandParent.push_back(slotGenerations.size() - 1);
+    slotIslandNext.push_back(slotGenerations.size() - 1);
+    return slotGenerations.size() - 1;
+}
+
+void BallPhysics::link_newest_slot(unsigned int slot)
+{
+    slotOlder[slot] = newestSlot;
+    slotNewer[slot] = noSlot;
+    if(newestSlot != noSlot)
+        slotNewer[newestSlot] = slot;
+    else
+        oldestSlot = slot;
+    newestSlot = slot;
+}
+
+void BallPhysics::unlink_slot(unsigned int slot)
+{
+    if(slotOlder[slot] != noSlot)
+        slotNewer[slotOlder[slot]] = slotNewer[slot];
+    else
+        oldestSlot = slotNewer[slot];
+    if(slotNewer[slot] != noSlot)
+        slotOlder[slotNewer[slot]] = slotOlder[slot];
+    else
+        newestSlot = slotOlder[slot];
+}
+
+void BallPhysics::swap_balls(unsigned int firstIndex, unsigned int secondIndex)
+{
+    if(firstIndex == secondIndex)
+        return;
+    balls.swap(firstIndex, secondIndex);
+    std::swap(ballSlots[firstIndex], ballSlots[secondIndex]);
+    slotIndices[ballSlots[firstIndex]] = firstIndex;
+    slotIndices[ballSlots[secondIndex]] = secondIndex;
+}
+
+// Awake balls whose displacement over the step stays below the velocity
+// threshold accumulate sleep time. Displacement is used rather than velocity
+// because balls resting on the floor or in a stack keep bouncing in place
+// at up to |gravity|*deltaTime per step. Touching awake balls form islands,
+// and an island only goes to sleep once every member has been slow for the
+// time threshold. Sleeping islands are kept as circular lists of slots so a
+// moving ball hitting any member wakes the whole island in time
+// proportional to its size.
+void BallPhysics::update_sleep_states(float deltaTime)
+{
+    PROFILE_PHASE(phaseprofiler::sleeping);
+    TRACE_SCOPE("BallPhysics::update_sleep_states");
+    float sleepDistance{sleepVelocityThreshold*deltaTime};
+    float sleepDistanceSquared{sleepDistance*sleepDistance};
+    islandParent.resize(awakeCount);
+    islandQuiet.assign(awakeCount, 1);
+    for(unsigned int ballIndex{0}; ballIndex < awakeCount; ballIndex++)
+    {
+        islandParent[ballIndex] = ballIndex;
+        if(get_step_displacement_squared(ballIndex) <= sleepDistanceSquared)
+            balls.sleepTime[ballIndex] += deltaTime;
+        else
+            balls.sleepTime[ballIndex] = 0;
+    }
+
+    sleepingContacts.clear();
+    wakeSlots.clear();
+    for(const BallPair &pair : collisionPairs)
+    {
+        float contactDistance{(balls.radius[pair.first] + balls.radius[pair.second])*(1 + sleepContactMargin)};
+        if((balls.get_position(pair.first) - balls.get_position(pair.second)).squaredNorm() > contactDistance*contactDistance)
+            continue;
+        if(pair.second < awakeCount)
+            islandParent[find_island(pair.second)] = find_island(pair.first);
+        else if(get_step_displacement_squared(pair.first) > sleepDistanceSquared)
+            wakeSlots.push_back(ballSlots[pair.second]);
+        else
+            sleepingContacts.push_back(pair);
+    }
+
+    for(unsigned int ballIndex{0}; ballIndex < awakeCount; ballIndex++)
+    {
+        if(balls.sleepTime[ballIndex] < sleepTimeThreshold)
+            islandQuiet[find_island(ballIndex)] = 0;
+    }
+
+    sleepingSlots.clear();
+    for(unsigned int ballIndex{0}; ballIndex < awakeCount; ballIndex++)
+    {
+        unsigned int root{find_island(ballIndex)};
+        if(!islandQuiet[root])
+            continue;
+        unsigned int slot{ballSlots[ballIndex]};
+        unsigned int rootSlot{ballSlots[root]};
+        if(slot != rootSlot)
+        {
+            slotIslandParent[slot] = rootSlot;
+            slotIslandNext[slot] = slotIslandNext[rootSlot];
+            slotIslandNext[rootSlot] = slot;
+        }
+        sleepingSlots.push_back(slot);
+    }
+    for(const BallPair &pair : sleepingContacts)
+    {
+        if(islandQuiet[find_island(pair.first)])
+            merge_sleeping_islands(ballSlots[pair.first], ballSlots[pair.second]);
+    }
+
+    for(unsigned int slot : sleepingSlots)
+    {
+        unsigned int index{slotIndices[slot]};
+        balls.set_velocity(index, Eigen::Vector3f{0.0, 0.0, 0.0});
+        balls.previousPositionX[index] = balls.positionX[index];
+        balls.previousPositionY[index] = balls.positionY[index];
+        balls.previousPositionZ[index] = balls.positionZ[index];
+        awakeCount--;
+        swap_balls(index, awakeCount);
+    }
+    for(unsigned int slot : wakeSlots)
+    {
+        if(slotIndices[slot] >= awakeCount)
+            wake_island(slot);
+    }
+}
+
+float BallPhysics::get_step_displacement_squared(unsigned int index)
+{
+    Eigen::Vector3f previousPosition{balls.previousPositionX[index], balls.previousPositionY[index], balls.previousPositionZ[index]};
+    return (balls.get_position(index) - previousPosition).squaredNorm();
+}
+
+unsigned int BallPhysics::find_island(unsigned int index)
+{
+    while(islandParent[index] != index)
+    {
+        islandParent[index] = islandParent[islandParent[index]];
+        index = islandParent[index];
+    }
+    return index;
+}
+
+unsigned int BallPhysics::find_sleeping_island(unsigned int slot)
+{
+    while(slotIslandParent[slot] != slot)
+    {
+        slotIslandParent[slot] = slotIslandParent[slotIslandParent[slot]];
+        slot = slotIslandParent[slot];
+    }
+    return slot;
+}
+
+// Swapping the successors of one member from each circular list splices
+// two distinct lists into one.
+void BallPhysics::merge_sleeping_islands(unsigned int firstSlot, unsigned int secondSlot)
+{
+    unsigned int firstRoot{find_sleeping_island(firstSlot)};
+    unsigned int secondRoot{find_sleeping_island(secondSlot)};
+    if(firstRoot == secondRoot)
+        return;
+    slotIslandParent[secondRoot] = firstRoot;
+    std::swap(slotIslandNext[firstRoot], slotIslandNext[secondRoot]);
+}
+
+void BallPhysics::wake_island(unsigned int slot)
+{
+    unsigned int memberSlot{slot};
+    do
+    {
+        unsigned int nextSlot{slotIslandNext[memberSlot]};
+        slotIslandParent[memberSlot] = memberSlot;
+        slotIslandNext[memberSlot] = memberSlot;
+        swap_balls(slotIndices[memberSlot], awakeCount);
+        balls.sleepTime[awakeCount] = 0;
+        awakeCount++;
+        memberSlot = nextSlot;
+    } while(memberSlot != slot);
+}
+
+// Copy assignment reuses the capacity the state already has, so saving into
+// a recycled state of the same size does not allocate.
+void BallPhysics::save_state(BallPhysicsState &state)
+{
+    state.balls = balls;
+    state.gravity = gravity;
+    state.ballCount = ballCount;
+    state.awakeCount = awakeCount;
+    state.maxBallCount = maxBallCount;
+    state.boxBoundSize = boxBoundSize;
+    state.dragCoefficient = dragCoefficient;
+    state.fluidDensity = fluidDensity;
+    state.newBallRadius = newBallRadius;
+    state.newBallMass = newBallMass;
+    state.newBallColor = newBallColor;
+    state.newBallPosition = newBallPosition;
+    state.newBallVelocity = newBallVelocity;
+    state.newBallCoefficientOfRestitution = newBallCoefficientOfRestitution;
+    state.slotGenerations = slotGenerations;
+    state.slotIndices = slotIndices;
+    state.slotOlder = slotOlder;
+    state.slotNewer = slotNewer;
+    state.freeSlots = freeSlots;
+    state.ballSlots = ballSlots;
+    state.oldestSlot = oldestSlot;
+    state.newestSlot = newestSlot;
+    state.sleepingEnabled = sleepingEnabled;
+    state.sleepVelocityThreshold = sleepVelocityThreshold;
+    state.sleepTimeThreshold = sleepTimeThreshold;
+    state.slotIslandParent = slotIslandParent;
+    state.slotIslandNext = slotIslandNext;
+    state.emitters = emitters;
+    state.contactCache = contactSolver.get_cache();
+    state.stepCount = stepCount;
+    state.revisionCounter = revisionCounter;
+}
+
+// Restoring winds the revision counter back, so balls spawned afterwards
+// reuse revisions the renderer has already drawn. Snapshots carry the
+// restore count so the renderer redraws every color once it changes.
+void BallPhysics::restore_state(const BallPhysicsState &state)
+{
+    balls = state.balls;
+    gravity = state.gravity;
+    ballCount = state.ballCount;
+    awakeCount = state.awakeCount;
+    maxBallCount = state.maxBallCount;
+    boxBoundSize = state.boxBoundSize;
+    dragCoefficient = state.dragCoefficient;
+    fluidDensity = state.fluidDensity;
+    newBallRadius = state.newBallRadius;
+    newBallMass = state.newBallMass;
+    newBallColor = state.newBallColor;
+    newBallPosition = state.newBallPosition;
+    newBallVelocity = state.newBallVelocity;
+    newBallCoefficientOfRestitution = state.newBallCoefficientOfRestitution;
+    slotGenerations = state.slotGenerations;
+    slotIndices = state.slotIndices;
+    slotOlder = state.slotOlder;
+    slotNewer = state.slotNewer;
+    freeSlots = state.freeSlots;
+    ballSlots = state.ballSlots;
+    oldestSlot = state.oldestSlot;
+    newestSlot = state.newestSlot;
+    sleepingEnabled = state.sleepingEnabled;
+    sleepVelocityThreshold = state.sleepVelocityThreshold;
+    sleepTimeThreshold = state.sleepTimeThreshold;
+    slotIslandParent = state.slotIslandParent;
+    slotIslandNext = state.slotIslandNext;
+    emitters = state.emitters;
+    contactSolver.restore_cache(state.contactCache);
+    stepCount = state.stepCount;
+    revisionCounter = state.revisionCounter;
+    restoreCount++;
+    balls.reserve(maxBallCount);
+    reserve_slots(maxBallCount);
+    reserve_step_buffers(maxBallCount);
+    snapshots->reserve(maxBallCount);
+}
+
+bool BallPhysics::save_scene(const std::string &path)
+{
+    scenefile::Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.stepCount = stepCount;
+    header.ballCount = ballCount;
+    header.maxBallCount = maxBallCount;
+    header.revisionCounter = revisionCounter;
+    header.gravity = gravity;
+    header.boxBoundSize = boxBoundSize;
+    header.dragCoefficient = dragCoefficient;
+    header.fluidDensity = fluidDensity;
+    header.sleepingEnabled = sleepingEnabled;
+    header.sleepVelocityThreshold = sleepVelocityThreshold;
+    header.sleepTimeThreshold = sleepTimeThreshold;
+    header.newBallRadius = newBallRadius;
+    header.newBallMass = newBallMass;
+    header.newBallColor = newBallColor;
+    for(int axis{0}; axis < 3; axis++)
+    {
+        header.newBallPosition[axis] = newBallPosition[axis];
+        header.newBallVelocity[axis] = newBallVelocity[axis];
+    }
+    header.newBallCoefficientOfRestitution = newBallCoefficientOfRestitution;
+
+    std::vector<scenefile::EmitterRecord> emitterRecords;
+    for(Emitter &emitter : emitters)
+        emitterRecords.push_back(scenefile::make_emitter_record(emitter));
+
+    std::vector<unsigned int> spawnOrder;
+    spawnOrder.reserve(ballCount);
+    for(unsigned int slot{oldestSlot}; slot != noSlot; slot = slotNewer[slot])
+        spawnOrder.push_back(slotIndices[slot]);
+    return scenefile::write(path, header, emitterRecords, balls, spawnOrder);
 }
 
-void BallPhysics::update_box_collisions(Ball &ball)
+// Replaces the whole simulation with the scene in path, or leaves it
+// untouched if the file is not a valid scene. Every loaded ball gets a new
+// handle, and all of them start awake; islands that were asleep go back to
+// sleep on the next step since their sleep times are restored too. The file
+// numbers its revisions from zero, so they are moved past every revision
+// this simulation has handed out and none is ever reused.
+bool BallPhysics::load_scene(const std::string &path)
 {
+    scenefile::MappedFile file;
+    if(!file.open(path))
+        return false;
+    const scenefile::Header &header = file.get_header();
+    const std::uint32_t *spawnOrder{file.get_spawn_order()};
+    std::vector<bool> spawned(header.ballCount, false);
+    for(unsigned int order{0}; order < header.ballCount; order++)
+    {
+        if(spawnOrder[order] >= header.ballCount || spawned[spawnOrder[order]])
+            return false;
+        spawned[spawnOrder[order]] = true;
+    }
+    std::vector<Emitter> loadedEmitters(header.emitterCount);
+    for(unsigned int emitterIndex{0}; emitterIndex < header.emitterCount; emitterIndex++)
+    {
+        if(!scenefile::make_emitter(file.get_emitters()[emitterIndex], loadedEmitters[emitterIndex]))
+            return false;
+    }
+
+    clear_balls();
+    emitters.swap(loadedEmitters);
+
+    this->gravity = header.gravity;
+    this->boxBoundSize = header.boxBoundSize;
+    this->dragCoefficient = header.dragCoefficient;
+    this->fluidDensity = header.fluidDensity;
+    this->sleepingEnabled = header.sleepingEnabled != 0;
+    this->sleepVelocityThreshold = header.sleepVelocityThreshold;
+    this->sleepTimeThreshold = header.sleepTimeThreshold;
+    this->newBallRadius = header.newBallRadius;
+    this->newBallMass = header.newBallMass;
+    this->newBallColor = header.newBallColor;
+    this->newBallPosition = Eigen::Vector3f{header.newBallPosition[0], header.newBallPosition[1], header.newBallPosition[2]};
+    this->newBallVelocity = Eigen::Vector3f{header.newBallVelocity[0], header.newBallVelocity[1], header.newBallVelocity[2]};
+    this->newBallCoefficientOfRestitution = header.newBallCoefficientOfRestitution;
+    this->stepCount = header.stepCount;
+    unsigned int revisionOffset{revisionCounter};
+    this->revisionCounter = revisionOffset + header.revisionCounter;
+    set_max_ball_count(header.maxBallCount);
+
+    file.copy_balls_to(balls);
+    for(unsigned int index{0}; index < header.ballCount; index++)
+        balls.revision[index] += revisionOffset;
+    this->ballCount = header.ballCount;
+    this->awakeCount = ballCount;
+    ballSlots.assign(ballCount, noSlot);
+    for(unsigned int order{0}; order < ballCount; order++)
+    {
+        unsigned int slot{allocate_slot()};
+        slotIndices[slot] = spawnOrder[order];
+        ballSlots[spawnOrder[order]] = slot;
+        link_newest_slot(slot);
+    }
+    return true;
+}
+
+void BallPhysics::publish_snapshot()
+{
+    snapshots->get_back().copy_from(balls, ballCount, stepCount);
+    snapshots->get_back().restoreCount = restoreCount;
+    snapshots->publish();
+}
+
+void BallPhysics::update_box_collisions(unsigned int ballIndex)
+{
+    float *position[3]{&balls.positionX[ballIndex], &balls.positionY[ballIndex], &balls.positionZ[ballIndex]};
+    float *velocity[3]{&balls.velocityX[ballIndex], &balls.velocityY[ballIndex], &balls.velocityZ[ballIndex]};
+    float radius{balls.radius[ballIndex]};
+    float coefficientOfRestitution{balls.coefficientOfRestitution[ballIndex]};
     for(int index{0}; index < 3; index++)
     {
-        if(index == 2 && ball.position[index] < ball.radius)
+        if(index == 2 && *position[index] < radius)
         {
-            ball.velocity[index] = ball.coefficientOfRestitution*fabs(ball.velocity[index]);
-            ball.position[index] = ball.radius;
+            *velocity[index] = coefficientOfRestitution*fabs(*velocity[index]);
+            *position[index] = radius;
         }
-        else if(index != 2 && fabs(ball.position[index]) > boxBoundSize-ball.radius)
+        else if(index != 2 && fabs(*position[index]) > boxBoundSize-radius)
         {
-            ball.velocity[index] = -ball.coefficientOfRestitution*ball.velocity[index];
-            ball.position[index] = copysign(boxBoundSize-ball.radius, ball.position[index]);
+            *velocity[index] = -coefficientOfRestitution*(*velocity[index]);
+            *position[index] = copysign(boxBoundSize-radius, *position[index]);
         }
     }
 }
 
-void BallPhysics::update_ball_collisions(Ball &ball, int &ballIndex)
+// Fast balls skip the box in integrate_balls so their whole path can be
+// swept; the projection solver clamps them once they are moved to impact.
+void BallPhysics::update_continuous_collisions()
+{
+    PROFILE_PHASE(phaseprofiler::ballCollisions);
+    TRACE_SCOPE("BallPhysics::update_continuous_collisions");
+    continuousCollision.sweep(balls, ballCount, awakeCount, boxBoundSize);
+    if(collisionSolverType == impulseSolver)
+        return;
+    for(unsigned int ballIndex : continuousCollision.get_swept_balls())
+        update_box_collisions(ballIndex);
+}
+
+// The impulse solver also handles the walls and floor, which the
+// projection solver leaves to update_box_collisions.
+void BallPhysics::update_ball_collisions(float deltaTime)
 {
-    for(int ballCollisionIndex{0}; ballCollisionIndex < ballCount; ballCollisionIndex++)
+    PROFILE_PHASE(phaseprofiler::ballCollisions);
+    TRACE_SCOPE("BallPhysics::update_ball_collisions");
     {
-        if(ballCollisionIndex == ballIndex)
-            continue;
-        else
+        TRACE_SCOPE("broadphase");
+        broadphase->build(balls, ballCount, boxBoundSize);
+        broadphase->find_pairs(collisionPairs, awakeCount);
+    }
+    if(collisionSolverType == impulseSolver)
+    {
+        TRACE_SCOPE("solve_contacts");
+        contactSolver.solve(balls, collisionPairs, ballSlots.data(), slotGenerations.data(), ballCount, awakeCount, boxBoundSize, deltaTime, *threadPool);
+        return;
+    }
+    if(threadPool->get_thread_count() == 1)
+    {
+        TRACE_SCOPE("resolve_collisions");
+        for(const BallPair &pair : collisionPairs)
+            resolve_ball_collision(pair.first, pair.second);
+        return;
+    }
+
+    {
+        TRACE_SCOPE("color_collision_pairs");
+        color_collision_pairs();
+    }
+    TRACE_SCOPE("resolve_collisions");
+    for(unsigned int color{0}; color + 1 < colorStart.size(); color++)
+    {
+        unsigned int firstPair{colorStart[color]};
+        unsigned int lastPair{colorStart[color + 1]};
+        unsigned int taskCount{(lastPair - firstPair + pairsPerTask - 1)/pairsPerTask};
+        threadPool->parallel_for(taskCount, [this, firstPair, lastPair](unsigned int taskIndex)
         {
-            Ball &ballCollisionCandidate = balls[ballCollisionIndex];
-            Eigen::Vector3f positionDifference = ball.position - ballCollisionCandidate.position;
-            float offsetFromBall = positionDifference.norm();
-            if(offsetFromBall < (ball.radius + ballCollisionCandidate.radius))
-            {
-                ballCollisionCandidate.position = ball.position - positionDifference/offsetFromBall*(ball.radius + ballCollisionCandidate.radius);
-                Eigen::Vector3f velocityDifference = ball.velocity - ballCollisionCandidate.velocity;
-                float totalMass = ball.mass + ballCollisionCandidate.mass;
-                ball.velocity = ball.coefficientOfRestitution*(ball.velocity - 2*ballCollisionCandidate.mass/totalMass*velocityDifference.dot(positionDifference)/pow(positionDifference.norm(),2)*positionDifference);
-                ballCollisionCandidate.velocity = ballCollisionCandidate.coefficientOfRestitution*(ballCollisionCandidate.velocity - 2*ball.mass/totalMass*(-velocityDifference).dot(-positionDifference)/pow(positionDifference.norm(),2)*(-positionDifference));
-            }
-        }
+            unsigned int taskStart{firstPair + taskIndex*pairsPerTask};
+            unsigned int taskEnd{std::min(taskStart + pairsPerTask, lastPair)};
+            for(unsigned int pairIndex{taskStart}; pairIndex < taskEnd; pairIndex++)
+                resolve_ball_collision(coloredPairs[pairIndex].first, coloredPairs[pairIndex].second);
+        });
+    }
+}
+
+// Each ball's pairs get strictly increasing colors in broadphase order, so no
+// two pairs of one color share a ball and every ball sees its pairs in the
+// same order as the serial loop. Resolving color by color therefore gives the
+// serial result for any thread count.
+// There are never more colors than pairs, so colorStart only grows along
+// with the pair list.
+void BallPhysics::color_collision_pairs()
+{
+    ballNextColor.assign(ballCount, 0);
+    pairColors.resize(collisionPairs.size());
+    colorStart.reserve(collisionPairs.capacity() + 1);
+    colorStart.assign(1, 0);
+    for(unsigned int pairIndex{0}; pairIndex < collisionPairs.size(); pairIndex++)
+    {
+        const BallPair &pair = collisionPairs[pairIndex];
+        unsigned int color{std::max(ballNextColor[pair.first], ballNextColor[pair.second])};
+        ballNextColor[pair.first] = color + 1;
+        ballNextColor[pair.second] = color + 1;
+        pairColors[pairIndex] = color;
+        if(color + 1 >= colorStart.size())
+            colorStart.resize(color + 2, 0);
+        colorStart[color]++;
     }
+
+    for(unsigned int color{1}; color < colorStart.size(); color++)
+        colorStart[color] += colorStart[color - 1];
+
+    coloredPairs.resize(collisionPairs.size());
+    for(unsigned int pairIndex{(unsigned int)collisionPairs.size()}; pairIndex-- > 0;)
+        coloredPairs[--colorStart[pairColors[pairIndex]]] = collisionPairs[pairIndex];
+}
+
+void BallPhysics::resolve_ball_collision(unsigned int ballIndex, unsigned int ballCollisionIndex)
+{
+    if(ballCollisionIndex >= awakeCount)
+    {
+        resolve_sleeping_collision(ballIndex, ballCollisionIndex);
+        return;
+    }
+    Eigen::Vector3f ballPosition{balls.get_position(ballIndex)};
+    Eigen::Vector3f candidatePosition{balls.get_position(ballCollisionIndex)};
+    Eigen::Vector3f positionDifference = ballPosition - candidatePosition;
+    float offsetFromBall = positionDifference.norm();
+    float ballRadius{balls.radius[ballIndex]};
+    float candidateRadius{balls.radius[ballCollisionIndex]};
+    if(offsetFromBall > 0 && offsetFromBall < (ballRadius + candidateRadius))
+    {
+        Eigen::Vector3f ballVelocity{balls.get_velocity(ballIndex)};
+        Eigen::Vector3f candidateVelocity{balls.get_velocity(ballCollisionIndex)};
+        float ballMass{balls.mass[ballIndex]};
+        float candidateMass{balls.mass[ballCollisionIndex]};
+        candidatePosition = ballPosition - positionDifference/offsetFromBall*(ballRadius + candidateRadius);
+        Eigen::Vector3f velocityDifference = ballVelocity - candidateVelocity;
+        float totalMass = ballMass + candidateMass;
+        ballVelocity = balls.coefficientOfRestitution[ballIndex]*(ballVelocity - 2*candidateMass/totalMass*velocityDifference.dot(positionDifference)/pow(positionDifference.norm(),2)*positionDifference);
+        candidateVelocity = balls.coefficientOfRestitution[ballCollisionIndex]*(candidateVelocity - 2*ballMass/totalMass*(-velocityDifference).dot(-positionDifference)/pow(positionDifference.norm(),2)*(-positionDifference));
+        balls.set_position(ballCollisionIndex, candidatePosition);
+        balls.set_velocity(ballIndex, ballVelocity);
+        balls.set_velocity(ballCollisionIndex, candidateVelocity);
+    }
+}
+
+// A sleeping ball stays put like a wall; only the awake ball is pushed out
+// and bounced. A fast hit wakes the island at the end of the step.
+void BallPhysics::resolve_sleeping_collision(unsigned int ballIndex, unsigned int sleepingIndex)
+{
+    Eigen::Vector3f positionDifference = balls.get_position(ballIndex) - balls.get_position(sleepingIndex);
+    float offsetFromBall = positionDifference.norm();
+    float contactDistance{balls.radius[ballIndex] + balls.radius[sleepingIndex]};
+    if(offsetFromBall > 0 && offsetFromBall < contactDistance)
+    {
+        Eigen::Vector3f normal = positionDifference/offsetFromBall;
+        balls.set_position(ballIndex, balls.get_position(sleepingIndex) + normal*contactDistance);
+        Eigen::Vector3f ballVelocity{balls.get_velocity(ballIndex)};
+        float normalSpeed{ballVelocity.dot(normal)};
+        if(normalSpeed < 0)
+            balls.set_velocity(ballIndex, ballVelocity - (1 + balls.coefficientOfRestitution[ballIndex])*normalSpeed*normal);
+    }
+}
+
+BallPtr BallPhysics::get_ball_ptr(int index)
+{
+    return BallPtr(balls, index);
+}
+
+Eigen::Vector3f BallPhysics::get_interpolated_position(unsigned int index, float alpha)
+{
+    return balls.get_interpolated_position(index, alpha);
+}
+
+SnapshotTripleBuffer* BallPhysics::get_snapshot_buffer()
+{
+    return this->snapshots.get();
+}
+
+TrajectoryRecorder* BallPhysics::get_trajectory_recorder()
+{
+    return this->trajectoryRecorder;
+}
+
+unsigned long BallPhysics::get_step_count()
+{
+    return this->stepCount;
+}
+
+unsigned int BallPhysics::get_ball_revision(unsigned int index)
+{
+    return balls.revision[index];
+}
+
+unsigned int BallPhysics::add_emitter(const Emitter &newEmitter)
+{
+    emitters.push_back(newEmitter);
+    return emitters.size() - 1;
 }
 
-Ball* BallPhysics::get_ball_ptr(int index)
+void BallPhysics::remove_emitter(unsigned int index)
 {
-    return &balls[index];
+    if(index < emitters.size())
+        emitters.erase(emitters.begin() + index);
+}
+
+void BallPhysics::clear_emitters()
+{
+    emitters.clear();
+}
+
+Emitter* BallPhysics::get_emitter_ptr(unsigned int index)
+{
+    return &emitters[index];
+}
+
+unsigned int BallPhysics::get_emitter_count()
+{
+    return emitters.size();
 }
 
 float BallPhysics::get_gravity()
@@ -130,11 +876,71 @@ unsigned int BallPhysics::get_ball_count()
     return this->ballCount;
 }
 
+unsigned int BallPhysics::get_awake_ball_count()
+{
+    return this->awakeCount;
+}
+
+bool BallPhysics::is_ball_sleeping(unsigned int index)
+{
+    return index >= awakeCount && index < ballCount;
+}
+
+bool BallPhysics::get_sleeping_enabled()
+{
+    return this->sleepingEnabled;
+}
+
+float BallPhysics::get_sleep_velocity_threshold()
+{
+    return this->sleepVelocityThreshold;
+}
+
+float BallPhysics::get_sleep_time_threshold()
+{
+    return this->sleepTimeThreshold;
+}
+
 unsigned int BallPhysics::get_max_ball_count()
 {
     return this->maxBallCount;
 }
 
+unsigned int BallPhysics::get_ball_replace_index()
+{
+    return oldestSlot != noSlot ? slotIndices[oldestSlot] : 0;
+}
+
+unsigned int BallPhysics::get_thread_count()
+{
+    return this->threadPool->get_thread_count();
+}
+
+BroadphaseType BallPhysics::get_broadphase_type()
+{
+    return this->broadphaseType;
+}
+
+CollisionSolverType BallPhysics::get_collision_solver_type()
+{
+    return this->collisionSolverType;
+}
+
+ContactSolver* BallPhysics::get_contact_solver_ptr()
+{
+    return &this->contactSolver;
+}
+
+bool BallPhysics::get_continuous_collision_enabled()
+{
+    return this->continuousCollisionEnabled;
+}
+
+ContinuousCollision* BallPhysics::get_continuous_collision_ptr()
+{
+    return &this->continuousCollision;
+}
+
 float BallPhysics::get_box_size()
 {
     return this->boxBoundSize;
@@ -150,24 +956,98 @@ float BallPhysics::get_fluid_density()
     return this->fluidDensity;
 }
 
+void BallPhysics::set_max_ball_count(unsigned int newMaxCount)
+{
+    if(newMaxCount == 0)
+        return;
+    while(ballCount > newMaxCount)
+        remove_ball();
+    this->maxBallCount = newMaxCount;
+    balls.reserve(maxBallCount);
+    reserve_slots(maxBallCount);
+    reserve_step_buffers(maxBallCount);
+    snapshots->reserve(maxBallCount);
+}
+
+void BallPhysics::set_thread_count(unsigned int newThreadCount)
+{
+    if(newThreadCount == 0 || newThreadCount == threadPool->get_thread_count())
+        return;
+    threadPool.reset(new ThreadPool(newThreadCount));
+}
+
+// The broadphases find the same touching pairs but in their own order, so
+// switching can change how a step resolves a crowded pile.
+void BallPhysics::set_broadphase_type(BroadphaseType newType)
+{
+    if(newType == broadphaseType)
+        return;
+    if(newType == bruteForceBroadphase)
+        broadphase.reset(new BruteForceBroadphase);
+    else if(newType == sweepAndPruneBroadphase)
+        broadphase.reset(new SweepAndPrune);
+    else
+        broadphase.reset(new SpatialHashGrid);
+    this->broadphaseType = newType;
+    broadphase->reserve(maxBallCount);
+}
+
+void BallPhysics::set_collision_solver_type(CollisionSolverType newType)
+{
+    this->collisionSolverType = newType;
+    contactSolver.clear_cache();
+}
+
+void BallPhysics::set_continuous_collision_enabled(bool newEnabled)
+{
+    this->continuousCollisionEnabled = newEnabled;
+}
+
 void BallPhysics::set_gravity(float newGravity)
 {
     this->gravity = newGravity;
+    wake_balls();
 }
 
 void BallPhysics::set_box_size(float newSize)
 {
     this->boxBoundSize = newSize;
+    wake_balls();
 }
 
 void BallPhysics::set_drag_coefficient(float newCoefficient)
 {
     this->dragCoefficient = newCoefficient;
+    refresh_drag_constants();
+    wake_balls();
 }
 
 void BallPhysics::set_fluid_density(float newDensity)
 {
     this->fluidDensity = newDensity;
+    refresh_drag_constants();
+    wake_balls();
+}
+
+void BallPhysics::set_sleeping_enabled(bool newEnabled)
+{
+    this->sleepingEnabled = newEnabled;
+    if(!sleepingEnabled)
+        wake_balls();
+}
+
+void BallPhysics::set_sleep_thresholds(float newVelocityThreshold, float newTimeThreshold)
+{
+    this->sleepVelocityThreshold = newVelocityThreshold;
+    this->sleepTimeThreshold = newTimeThreshold;
+    wake_balls();
+}
+
+// The recorder is not owned; it sees every step after this call until it
+// is detached with nullptr.
+void BallPhysics::set_trajectory_recorder(TrajectoryRecorder *newRecorder)
+{
+    this->trajectoryRecorder = newRecorder;
 }
 
 float BallPhysics::get_new_ball_radius()
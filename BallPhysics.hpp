@@ -2,35 +2,147 @@
 #define BALLPHYSICS_HPP
 
 #include "Ball.hpp"
+#include "BallStorage.hpp"
+#include "Broadphase.hpp"
+#include "SpatialHashGrid.hpp"
+#include "BruteForceBroadphase.hpp"
+#include "SweepAndPrune.hpp"
+#include "ContactSolver.hpp"
+#include "ContinuousCollision.hpp"
+#include "ThreadPool.hpp"
+#include "IntegrationKernels.hpp"
+#include "BallSnapshot.hpp"
+#include "Emitter.hpp"
+#include "SceneFile.hpp"
+#include "TrajectoryRecorder.hpp"
+#include "PhaseProfiler.hpp"
+#include "FrameTracer.hpp"
+#include <algorithm>
+#include <memory>
+#include <string>
 #include <vector>
 #include <math.h>
 #include <iostream>
 #include <eigen3/Eigen/Dense>
 
+struct BallHandle
+{
+    unsigned int slot;
+    unsigned int generation;
+};
+
+bool operator==(const BallHandle &first, const BallHandle &second);
+bool operator!=(const BallHandle &first, const BallHandle &second);
+
+// Everything a step reads that a later step depends on, copied out as is so
+// a restored simulator continues bit for bit. Per-step scratch such as the
+// broadphase and the collision pairs is rebuilt by every step and left out.
+struct BallPhysicsState
+{
+    std::size_t get_memory_size() const;
+
+    BallStorage balls;
+    float gravity;
+    unsigned int ballCount;
+    unsigned int awakeCount;
+    unsigned int maxBallCount;
+    float boxBoundSize;
+    float dragCoefficient;
+    float fluidDensity;
+
+    float newBallRadius;
+    float newBallMass;
+    unsigned int newBallColor;
+    Eigen::Vector3f newBallPosition;
+    Eigen::Vector3f newBallVelocity;
+    float newBallCoefficientOfRestitution;
+
+    std::vector<unsigned int> slotGenerations;
+    std::vector<unsigned int> slotIndices;
+    std::vector<unsigned int> slotOlder;
+    std::vector<unsigned int> slotNewer;
+    std::vector<unsigned int> freeSlots;
+    std::vector<unsigned int> ballSlots;
+    unsigned int oldestSlot;
+    unsigned int newestSlot;
+
+    bool sleepingEnabled;
+    float sleepVelocityThreshold;
+    float sleepTimeThreshold;
+    std::vector<unsigned int> slotIslandParent;
+    std::vector<unsigned int> slotIslandNext;
+
+    std::vector<Emitter> emitters;
+    std::vector<CachedContact> contactCache;
+    unsigned long stepCount;
+    unsigned int revisionCounter;
+};
+
 class BallPhysics
 {
 public:
-    BallPhysics(float boxBoundSizeInput=30, float fluidDensityInput=0, float gravityInput=-9.81);
+    BallPhysics(float boxBoundSizeInput=30, float fluidDensityInput=0, float gravityInput=-9.81, unsigned int maxBallCountInput=100);
 
-    void add_ball();
+    BallHandle add_ball();
+    unsigned int add_balls(unsigned int count, const float *spawnAges=nullptr, BallHandle *handles=nullptr);
+    unsigned int emit_balls(float deltaTime);
+    unsigned int add_emitter(const Emitter &newEmitter);
+    void remove_emitter(unsigned int index);
+    void clear_emitters();
     void update_ball(unsigned int &index, Eigen::Vector3f &newBallAcceleration);
     void update(float deltaTime);
     void remove_ball();
+    bool remove_ball(BallHandle handle);
+    int lookup(BallHandle handle);
+    BallHandle get_ball_handle(unsigned int index);
     void clear_balls();
+    void wake_balls();
+    void publish_snapshot();
+    bool save_scene(const std::string &path);
+    bool load_scene(const std::string &path);
+    void save_state(BallPhysicsState &state);
+    void restore_state(const BallPhysicsState &state);
 
-    Ball* get_ball_ptr(int index);
+    BallPtr get_ball_ptr(int index);
+    Eigen::Vector3f get_interpolated_position(unsigned int index, float alpha);
+    SnapshotTripleBuffer* get_snapshot_buffer();
+    TrajectoryRecorder* get_trajectory_recorder();
+    Emitter* get_emitter_ptr(unsigned int index);
+    unsigned int get_emitter_count();
+    unsigned long get_step_count();
+    unsigned int get_ball_revision(unsigned int index);
 
     float get_gravity();
     unsigned int get_ball_count();
+    unsigned int get_awake_ball_count();
+    bool is_ball_sleeping(unsigned int index);
+    bool get_sleeping_enabled();
+    float get_sleep_velocity_threshold();
+    float get_sleep_time_threshold();
     unsigned int get_max_ball_count();
+    unsigned int get_ball_replace_index();
+    unsigned int get_thread_count();
+    BroadphaseType get_broadphase_type();
+    CollisionSolverType get_collision_solver_type();
+    ContactSolver* get_contact_solver_ptr();
+    bool get_continuous_collision_enabled();
+    ContinuousCollision* get_continuous_collision_ptr();
     float get_box_size();
     float get_drag_coefficient();
     float get_fluid_density();
 
+    void set_max_ball_count(unsigned int newMaxCount);
+    void set_thread_count(unsigned int newThreadCount);
+    void set_broadphase_type(BroadphaseType newType);
+    void set_collision_solver_type(CollisionSolverType newType);
+    void set_continuous_collision_enabled(bool newEnabled);
     void set_gravity(float newGravity);
     void set_box_size(float newSize);
     void set_drag_coefficient(float newCoefficient);
     void set_fluid_density(float newDensity);
+    void set_sleeping_enabled(bool newEnabled);
+    void set_sleep_thresholds(float newVelocityThreshold, float newTimeThreshold);
+    void set_trajectory_recorder(TrajectoryRecorder *newRecorder);
 
     float get_new_ball_radius();
     float get_new_ball_mass();
@@ -48,10 +160,10 @@ public:
     void set_new_ball_coefficient_of_restitution(float newCoefficient);
 
 protected:
-    std::vector<Ball> balls;
-    unsigned int ballReplaceIndex{0};
+    BallStorage balls;
     float gravity{-9.81};
     unsigned int ballCount{0};
+    unsigned int awakeCount{0};
     unsigned int maxBallCount{100};
     float boxBoundSize{30};
     float dragCoefficient{0.5};
@@ -64,9 +176,78 @@ protected:
     Eigen::Vector3f newBallVelocity{0.0, 0.0, 20.0};
     float newBallCoefficientOfRestitution{0.7};
 
+    std::vector<unsigned int> slotGenerations;
+    std::vector<unsigned int> slotIndices;
+    std::vector<unsigned int> slotOlder;
+    std::vector<unsigned int> slotNewer;
+    std::vector<unsigned int> freeSlots;
+    std::vector<unsigned int> ballSlots;
+    static const unsigned int noSlot{0xFFFFFFFF};
+    unsigned int oldestSlot{noSlot};
+    unsigned int newestSlot{noSlot};
+
+    bool sleepingEnabled{true};
+    float sleepVelocityThreshold{0.1};
+    float sleepTimeThreshold{0.5};
+    float sleepContactMargin{0.05};
+    std::vector<unsigned int> slotIslandParent;
+    std::vector<unsigned int> slotIslandNext;
+    std::vector<unsigned int> islandParent;
+    std::vector<unsigned char> islandQuiet;
+    std::vector<BallPair> sleepingContacts;
+    std::vector<unsigned int> sleepingSlots;
+    std::vector<unsigned int> wakeSlots;
+
+    std::vector<Emitter> emitters;
+
+    BroadphaseType broadphaseType{spatialHashBroadphase};
+    std::unique_ptr<Broadphase> broadphase{new SpatialHashGrid};
+    std::vector<BallPair> collisionPairs;
+    std::vector<BallPair> coloredPairs;
+    std::vector<unsigned int> pairColors;
+    std::vector<unsigned int> colorStart;
+    std::vector<unsigned int> ballNextColor;
+    CollisionSolverType collisionSolverType{projectionSolver};
+    ContactSolver contactSolver;
+    bool continuousCollisionEnabled{false};
+    ContinuousCollision continuousCollision;
+
+    std::unique_ptr<ThreadPool> threadPool{new ThreadPool(1)};
+    unsigned int ballsPerTask{1024};
+    unsigned int pairsPerTask{512};
+    unsigned int reservedPairsPerBall{8};
+    integrationkernels::IntegrateFunction integrate{integrationkernels::select_integrate_function()};
+
+    std::unique_ptr<SnapshotTripleBuffer> snapshots{new SnapshotTripleBuffer};
+    TrajectoryRecorder *trajectoryRecorder{nullptr};
+    unsigned long stepCount{0};
+    unsigned int revisionCounter{0};
+    unsigned int restoreCount{0};
+
 private:
-    void update_box_collisions(Ball &ball);
-    void update_ball_collisions(Ball &ball, int &ballIndex);
+    BallHandle launch_ball(Ball newBall, float spawnAge);
+    BallHandle spawn_ball(const Ball &newBall, float newDragConstant);
+    void reserve_slots(unsigned int capacity);
+    void reserve_step_buffers(unsigned int capacity);
+    unsigned int allocate_slot();
+    void link_newest_slot(unsigned int slot);
+    void unlink_slot(unsigned int slot);
+    void swap_balls(unsigned int firstIndex, unsigned int secondIndex);
+    void update_sleep_states(float deltaTime);
+    float get_step_displacement_squared(unsigned int index);
+    unsigned int find_island(unsigned int index);
+    unsigned int find_sleeping_island(unsigned int slot);
+    void merge_sleeping_islands(unsigned int firstSlot, unsigned int secondSlot);
+    void wake_island(unsigned int slot);
+    float compute_drag_constant(float radius, float inverseMass);
+    void refresh_drag_constants();
+    void integrate_balls(unsigned int firstIndex, unsigned int lastIndex, float deltaTime);
+    void update_box_collisions(unsigned int ballIndex);
+    void update_continuous_collisions();
+    void update_ball_collisions(float deltaTime);
+    void color_collision_pairs();
+    void resolve_ball_collision(unsigned int ballIndex, unsigned int ballCollisionIndex);
+    void resolve_sleeping_collision(unsigned int ballIndex, unsigned int sleepingIndex);
 };
 
 #endif
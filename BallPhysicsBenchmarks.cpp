@@ -0,0 +1,181 @@
+#include "benchmark/benchmark.h"
+#include "BallPhysics.hpp"
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+const float stepTime{1.0/120};
+const float ballRadius{0.5};
+const float pileFluidDensity{1.2};
+const int settleSteps{120};
+
+// Packs balls touching each other in layers on the floor. The box is sized
+// so the pile is about ten layers deep.
+void fill_dense_pile(BallPhysics &physics, unsigned int ballCount)
+{
+    unsigned int side{(unsigned int)ceil(sqrt(ballCount/10.0))};
+    float spacing{2*ballRadius};
+    physics.set_box_size(side*spacing/2 + spacing);
+    physics.set_new_ball_radius(ballRadius);
+    physics.set_new_ball_velocity(Eigen::Vector3f{0.0, 0.0, 0.0});
+    for(unsigned int ballIndex{0}; ballIndex < ballCount; ballIndex++)
+    {
+        float x{(ballIndex%side - side/2.0f)*spacing};
+        float y{((ballIndex/side)%side - side/2.0f)*spacing};
+        float z{ballRadius + ballIndex/(side*side)*spacing};
+        physics.set_new_ball_position(Eigen::Vector3f{x, y, z});
+        physics.add_ball();
+    }
+}
+
+// Spreads balls through a large weightless box with about eight radii
+// between neighbours, so few of them touch and none come to rest.
+void fill_sparse_fountain(BallPhysics &physics, unsigned int ballCount)
+{
+    unsigned int side{(unsigned int)ceil(cbrt(ballCount))};
+    float spacing{8*ballRadius};
+    std::mt19937 generator{1};
+    std::uniform_real_distribution<float> speed{-5, 5};
+    physics.set_gravity(0);
+    physics.set_box_size(side*spacing/2 + spacing);
+    physics.set_new_ball_radius(ballRadius);
+    for(unsigned int ballIndex{0}; ballIndex < ballCount; ballIndex++)
+    {
+        float x{(ballIndex%side - side/2.0f)*spacing};
+        float y{((ballIndex/side)%side - side/2.0f)*spacing};
+        float z{ballRadius + ballIndex/(side*side)*spacing};
+        physics.set_new_ball_position(Eigen::Vector3f{x, y, z});
+        physics.set_new_ball_velocity(Eigen::Vector3f{speed(generator), speed(generator), speed(generator)});
+        physics.add_ball();
+    }
+}
+
+// Brute force is left out past ten thousand balls, where one step takes
+// seconds.
+void add_broadphase_arguments(benchmark::internal::Benchmark *benchmark)
+{
+    for(int type{bruteForceBroadphase}; type <= sweepAndPruneBroadphase; type++)
+        for(int ballCount : {100, 1000, 10000, 100000})
+            for(int scene{0}; scene < 2; scene++)
+                if(type != bruteForceBroadphase || ballCount <= 10000)
+                    benchmark->Args({type, ballCount, scene});
+}
+
+void set_step_counters(benchmark::State &state, BallPhysics &physics)
+{
+    state.SetItemsProcessed(state.iterations()*physics.get_ball_count());
+    state.counters["balls"] = physics.get_ball_count();
+    state.counters["awake_balls"] = physics.get_awake_ball_count();
+}
+}
+
+// Arguments: ball count, drag on, sleeping on. The pile is given a second
+// to settle first so the sleeping case measures the resting steady state.
+static void BM_StepDensePile(benchmark::State &state)
+{
+    BallPhysics physics(30, state.range(1) ? pileFluidDensity : 0, -9.81, state.range(0));
+    physics.set_sleeping_enabled(state.range(2));
+    fill_dense_pile(physics, state.range(0));
+    for(int step{0}; step < settleSteps; step++)
+        physics.update(stepTime);
+    for(auto _ : state)
+        physics.update(stepTime);
+    set_step_counters(state, physics);
+}
+
+// Arguments: ball count, drag on.
+static void BM_StepSparseFountain(benchmark::State &state)
+{
+    BallPhysics physics(30, state.range(1) ? pileFluidDensity : 0, -9.81, state.range(0));
+    fill_sparse_fountain(physics, state.range(0));
+    for(auto _ : state)
+        physics.update(stepTime);
+    set_step_counters(state, physics);
+}
+
+// Arguments: broadphase type, ball count, scene (0 for the dense pile
+// without sleeping, 1 for the sparse fountain).
+static void BM_StepBroadphase(benchmark::State &state)
+{
+    BallPhysics physics(30, 0, -9.81, state.range(1));
+    physics.set_broadphase_type(BroadphaseType(state.range(0)));
+    physics.set_sleeping_enabled(false);
+    if(state.range(2) == 0)
+        fill_dense_pile(physics, state.range(1));
+    else
+        fill_sparse_fountain(physics, state.range(1));
+    for(auto _ : state)
+        physics.update(stepTime);
+    set_step_counters(state, physics);
+}
+
+// Arguments: collision solver type, ball count. The dense pile without
+// sleeping, stepped at 30 Hz, the rate the impulse solver is meant to hold
+// a pile at.
+static void BM_StepPileSolver(benchmark::State &state)
+{
+    BallPhysics physics(30, 0, -9.81, state.range(1));
+    physics.set_collision_solver_type(CollisionSolverType(state.range(0)));
+    physics.set_sleeping_enabled(false);
+    fill_dense_pile(physics, state.range(1));
+    for(int step{0}; step < settleSteps/4; step++)
+        physics.update(4*stepTime);
+    for(auto _ : state)
+        physics.update(4*stepTime);
+    set_step_counters(state, physics);
+}
+
+// The simulator is full, so every add_ball recycles the oldest ball.
+static void BM_AddBallRingReplace(benchmark::State &state)
+{
+    BallPhysics physics(30, 0, -9.81, state.range(0));
+    for(unsigned int ballIndex{0}; ballIndex < state.range(0); ballIndex++)
+        physics.add_ball();
+    for(auto _ : state)
+        benchmark::DoNotOptimize(physics.add_ball());
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_StepDensePile)
+    ->ArgNames({"balls", "drag", "sleeping"})
+    ->ArgsProduct({{100, 1000, 10000, 100000}, {0, 1}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_StepSparseFountain)
+    ->ArgNames({"balls", "drag"})
+    ->ArgsProduct({{100, 1000, 10000, 100000}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_StepBroadphase)
+    ->ArgNames({"broadphase", "balls", "sparse"})
+    ->Apply(add_broadphase_arguments)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_StepPileSolver)
+    ->ArgNames({"solver", "balls"})
+    ->ArgsProduct({{projectionSolver, impulseSolver}, {1000, 10000, 100000}})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_AddBallRingReplace)
+    ->ArgName("balls")
+    ->Arg(100)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// Reports are JSON unless another --benchmark_format is given, so results
+// can be diffed between releases.
+int main(int argc, char **argv)
+{
+    std::vector<char*> arguments(argv, argv + argc);
+    bool formatGiven{false};
+    for(int argumentIndex{1}; argumentIndex < argc; argumentIndex++)
+        formatGiven = formatGiven || strncmp(argv[argumentIndex], "--benchmark_format", 18) == 0;
+    std::string jsonFormat{"--benchmark_format=json"};
+    if(!formatGiven)
+        arguments.push_back(&jsonFormat[0]);
+    int argumentCount{(int)arguments.size()};
+    benchmark::Initialize(&argumentCount, arguments.data());
+    if(benchmark::ReportUnrecognizedArguments(argumentCount, arguments.data()))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -185,12 +185,12 @@ TEST_F(PhysicsTests, WhenAddingMultipleBalls_ExpectCorrectInitializationOfAllBal
 TEST_F(PhysicsTests, WhenGettingBallPointer_ExpectCorrectValuesAtPointerAddress)
 {
     int numberOfBalls{20};
-    for(int index{0}; index < numberOfBalls-2; index++)
+    for(int index{0}; index < numberOfBalls-1; index++)
         physics.add_ball();
     physics.set_new_ball_parameters(radius, mass, color, position, velocity, coefficientOfRestitution);
     physics.add_ball();
 
-    Ball *ball = physics.get_ball_ptr(numberOfBalls-1);
+    BallPtr ball = physics.get_ball_ptr(numberOfBalls-1);
 
     EXPECT_EQ(ball->radius, radius);
     EXPECT_EQ(ball->mass, mass);
@@ -460,7 +460,23 @@ TEST_F(PhysicsTests, WhenBallIsMovingWithFluidDensity_ExpectDampedBallAccelerati
 
     physics.update(zeroTime);
 
-    EXPECT_VECTOR3_FLOAT_EQ(physics.get_ball_ptr(0)->acceleration, acceleration);
+    for(int index{0}; index < 3; index++)
+        EXPECT_FLOAT_EQ(physics.get_ball_ptr(0)->acceleration[index], acceleration[index]);
+}
+
+TEST_F(PhysicsTests, WhenChangingFluidDensity_ExpectCachedDragRefreshedForExistingBalls)
+{
+    physics.set_new_ball_parameters(radius, mass, color, position, velocity, coefficientOfRestitution);
+    physics.add_ball();
+
+    physics.set_fluid_density(fluidDensity);
+    physics.update(zeroTime);
+
+    float velocityMagnitude = velocity.norm();
+    Eigen::Vector3f dragForce = -(0.5*fluidDensity*pow(velocityMagnitude, 2)*physics.get_drag_coefficient()*(M_PI*pow(radius, 2)))/mass*velocity/velocityMagnitude;
+    acceleration = Eigen::Vector3f{0, 0, physics.get_gravity()} + dragForce;
+    for(int index{0}; index < 3; index++)
+        EXPECT_FLOAT_EQ(physics.get_ball_ptr(0)->acceleration[index], acceleration[index]);
 }
 
 TEST_F(PhysicsTests, WhenBallNotMovingWithFluidDensity_ExpectNoChange)
@@ -510,3 +526,529 @@ TEST_F(PhysicsTests, WhenClearingNoBalls_ExpectNoBallsAndNoCount)
 
     EXPECT_EQ(physics.get_ball_count(), 0);
 }
+
+TEST_F(PhysicsTests, WhenInitializingPhysicsWithCapacity_ExpectCorrectMaxBallCount)
+{
+    unsigned int capacity{5000};
+    physics = BallPhysics(boxSize, fluidDensity, gravity, capacity);
+
+    EXPECT_EQ(physics.get_max_ball_count(), capacity);
+}
+
+TEST_F(PhysicsTests, WhenAddingBalls_ExpectReturnedSlotIndices)
+{
+    int numberOfBalls{10};
+
+    for(int index{0}; index < numberOfBalls; index++)
+        EXPECT_EQ(physics.lookup(physics.add_ball()), index);
+}
+
+TEST_F(PhysicsTests, WhenAddingBallsPastCapacity_ExpectOldestSlotsRecycledInRingOrder)
+{
+    unsigned int capacity{4};
+    physics.set_max_ball_count(capacity);
+    for(unsigned int count{0}; count < capacity; count++)
+        physics.add_ball();
+
+    for(unsigned int count{0}; count < 3*capacity; count++)
+        EXPECT_EQ(physics.lookup(physics.add_ball()), count % capacity);
+
+    EXPECT_EQ(physics.get_ball_count(), capacity);
+    EXPECT_EQ(physics.get_ball_replace_index(), 0);
+}
+
+TEST_F(PhysicsTests, WhenReducingMaxBallCount_ExpectBallCountTruncated)
+{
+    unsigned int capacity{10};
+    for(int count{0}; count < 20; count++)
+        physics.add_ball();
+
+    physics.set_max_ball_count(capacity);
+
+    EXPECT_EQ(physics.get_max_ball_count(), capacity);
+    EXPECT_EQ(physics.get_ball_count(), capacity);
+}
+
+TEST_F(PhysicsTests, WhenIncreasingMaxBallCountAtRuntime_ExpectMoreBallsAccepted)
+{
+    unsigned int capacity{1000};
+    physics.set_max_ball_count(capacity);
+
+    for(unsigned int count{0}; count < capacity; count++)
+        physics.add_ball();
+
+    EXPECT_EQ(physics.get_ball_count(), capacity);
+}
+
+TEST_F(PhysicsTests, WhenSettingThreadCount_ExpectCorrectValue)
+{
+    physics.set_thread_count(4);
+
+    EXPECT_EQ(physics.get_thread_count(), 4);
+}
+
+TEST_F(PhysicsTests, WhenSettingZeroThreadCount_ExpectNoChange)
+{
+    physics.set_thread_count(0);
+
+    EXPECT_EQ(physics.get_thread_count(), 1);
+}
+
+TEST_F(PhysicsTests, WhenUpdatingDensePileWithMultipleThreads_ExpectSameStateAsSingleThread)
+{
+    BallPhysics serialPhysics(boxSize, fluidDensity, gravity, 5000);
+    BallPhysics parallelPhysics(boxSize, fluidDensity, gravity, 5000);
+    parallelPhysics.set_thread_count(4);
+    for(int count{0}; count < 5000; count++)
+    {
+        Eigen::Vector3f spawnPosition{float(count%20), float((count/20)%20), float(1 + count/400)};
+        serialPhysics.set_new_ball_position(spawnPosition);
+        parallelPhysics.set_new_ball_position(spawnPosition);
+        serialPhysics.add_ball();
+        parallelPhysics.add_ball();
+    }
+
+    for(int step{0}; step < 20; step++)
+    {
+        serialPhysics.update(0.01);
+        parallelPhysics.update(0.01);
+    }
+
+    for(unsigned int index{0}; index < serialPhysics.get_ball_count(); index++)
+    {
+        for(int axis{0}; axis < 3; axis++)
+        {
+            EXPECT_EQ(parallelPhysics.get_ball_ptr(index)->position[axis], serialPhysics.get_ball_ptr(index)->position[axis]);
+            EXPECT_EQ(parallelPhysics.get_ball_ptr(index)->velocity[axis], serialPhysics.get_ball_ptr(index)->velocity[axis]);
+        }
+    }
+}
+
+TEST_F(PhysicsTests, WhenAddingBall_ExpectPreviousPositionAtSpawnPosition)
+{
+    physics.set_new_ball_parameters(radius, mass, color, position, velocity, coefficientOfRestitution);
+    physics.add_ball();
+
+    EXPECT_VECTOR3_FLOAT_EQ(physics.get_ball_ptr(0)->previousPosition, position);
+    EXPECT_VECTOR3_FLOAT_EQ(physics.get_interpolated_position(0, 0.5), position);
+}
+
+TEST_F(PhysicsTests, WhenInterpolatingAfterUpdate_ExpectBlendOfPreviousAndCurrentPositions)
+{
+    physics.set_new_ball_parameters(radius, mass, color, position, velocity, coefficientOfRestitution);
+    physics.add_ball();
+
+    physics.update(deltaTime);
+
+    Eigen::Vector3f currentPosition{physics.get_ball_ptr(0)->position};
+    EXPECT_VECTOR3_FLOAT_EQ(physics.get_ball_ptr(0)->previousPosition, position);
+    EXPECT_VECTOR3_FLOAT_EQ(physics.get_interpolated_position(0, 0), position);
+    EXPECT_VECTOR3_FLOAT_EQ(physics.get_interpolated_position(0, 1), currentPosition);
+    EXPECT_TRUE(physics.get_interpolated_position(0, 0.5).isApprox(0.5*(position + currentPosition)));
+}
+
+TEST_F(PhysicsTests, WhenPublishingSnapshot_ExpectLatestStepVisibleToReader)
+{
+    physics.set_new_ball_parameters(radius, mass, color, position, velocity, coefficientOfRestitution);
+    physics.add_ball();
+    physics.update(deltaTime);
+
+    physics.publish_snapshot();
+
+    SnapshotTripleBuffer *snapshots = physics.get_snapshot_buffer();
+    EXPECT_TRUE(snapshots->acquire_latest());
+    EXPECT_EQ(snapshots->get_front().ballCount, 1);
+    EXPECT_EQ(snapshots->get_front().stepCount, physics.get_step_count());
+    EXPECT_VECTOR3_FLOAT_EQ(snapshots->get_front().get_interpolated_position(0, 1), physics.get_ball_ptr(0)->position);
+}
+
+TEST_F(PhysicsTests, WhenAddingBalls_ExpectUniqueNonZeroRevisions)
+{
+    physics.add_ball();
+    physics.add_ball();
+
+    EXPECT_NE(physics.get_ball_revision(0), 0);
+    EXPECT_NE(physics.get_ball_revision(1), 0);
+    EXPECT_NE(physics.get_ball_revision(0), physics.get_ball_revision(1));
+}
+
+TEST_F(PhysicsTests, WhenUpdatingPhysics_ExpectRevisionsUnchanged)
+{
+    physics.add_ball();
+    unsigned int revision{physics.get_ball_revision(0)};
+
+    physics.update(deltaTime);
+
+    EXPECT_EQ(physics.get_ball_revision(0), revision);
+}
+
+TEST_F(PhysicsTests, WhenRecyclingSlot_ExpectRevisionBumped)
+{
+    physics.set_max_ball_count(1);
+    physics.add_ball();
+    unsigned int revision{physics.get_ball_revision(0)};
+
+    physics.add_ball();
+
+    EXPECT_NE(physics.get_ball_revision(0), revision);
+}
+
+TEST_F(PhysicsTests, WhenRefillingSlotAfterClearing_ExpectNewRevision)
+{
+    physics.add_ball();
+    unsigned int revision{physics.get_ball_revision(0)};
+
+    physics.clear_balls();
+    physics.add_ball();
+
+    EXPECT_NE(physics.get_ball_revision(0), revision);
+}
+
+TEST_F(PhysicsTests, WhenAddingBall_ExpectValidHandleToBall)
+{
+    BallHandle handle{physics.add_ball()};
+
+    EXPECT_EQ(physics.lookup(handle), 0);
+    EXPECT_EQ(physics.get_ball_handle(0), handle);
+}
+
+TEST_F(PhysicsTests, WhenRemovingBallByHandle_ExpectLastBallMovedIntoHoleAndHandlesUpdated)
+{
+    physics.add_ball();
+    BallHandle removedHandle{physics.add_ball()};
+    physics.set_new_ball_position(position);
+    BallHandle lastHandle{physics.add_ball()};
+
+    EXPECT_TRUE(physics.remove_ball(removedHandle));
+
+    EXPECT_EQ(physics.get_ball_count(), 2);
+    EXPECT_EQ(physics.lookup(removedHandle), -1);
+    EXPECT_EQ(physics.lookup(lastHandle), 1);
+    EXPECT_VECTOR3_FLOAT_EQ(physics.get_ball_ptr(1)->position, position);
+}
+
+TEST_F(PhysicsTests, WhenRemovingBallTwice_ExpectSecondRemovalRejected)
+{
+    BallHandle handle{physics.add_ball()};
+    physics.remove_ball(handle);
+
+    EXPECT_FALSE(physics.remove_ball(handle));
+    EXPECT_EQ(physics.get_ball_count(), 0);
+}
+
+TEST_F(PhysicsTests, WhenSlotReusedAfterRemoval_ExpectStaleHandleRejected)
+{
+    BallHandle staleHandle{physics.add_ball()};
+    physics.remove_ball(staleHandle);
+
+    BallHandle newHandle{physics.add_ball()};
+
+    EXPECT_EQ(newHandle.slot, staleHandle.slot);
+    EXPECT_EQ(physics.lookup(staleHandle), -1);
+    EXPECT_EQ(physics.lookup(newHandle), 0);
+}
+
+TEST_F(PhysicsTests, WhenRecyclingOldestBall_ExpectItsHandleInvalidated)
+{
+    physics.set_max_ball_count(2);
+    BallHandle oldestHandle{physics.add_ball()};
+    BallHandle survivingHandle{physics.add_ball()};
+
+    physics.add_ball();
+
+    EXPECT_EQ(physics.lookup(oldestHandle), -1);
+    EXPECT_EQ(physics.lookup(survivingHandle), 1);
+}
+
+TEST_F(PhysicsTests, WhenRemovingBallsThenFillingToCapacity_ExpectOldestSurvivorRecycledFirst)
+{
+    physics.set_max_ball_count(3);
+    BallHandle firstHandle{physics.add_ball()};
+    BallHandle secondHandle{physics.add_ball()};
+    BallHandle thirdHandle{physics.add_ball()};
+    physics.remove_ball(firstHandle);
+    physics.add_ball();
+
+    physics.add_ball();
+
+    EXPECT_EQ(physics.lookup(secondHandle), -1);
+    EXPECT_NE(physics.lookup(thirdHandle), -1);
+}
+
+TEST_F(PhysicsTests, WhenClearingBalls_ExpectAllHandlesInvalidated)
+{
+    BallHandle handle{physics.add_ball()};
+
+    physics.clear_balls();
+
+    EXPECT_EQ(physics.lookup(handle), -1);
+}
+
+TEST_F(PhysicsTests, WhenAddingBallBatch_ExpectAllBallsSpawnedWithHandles)
+{
+    unsigned int count{50};
+    std::vector<BallHandle> handles(count);
+
+    EXPECT_EQ(physics.add_balls(count, nullptr, handles.data()), count);
+
+    EXPECT_EQ(physics.get_ball_count(), count);
+    for(unsigned int index{0}; index < count; index++)
+        EXPECT_EQ(physics.lookup(handles[index]), index);
+}
+
+TEST_F(PhysicsTests, WhenAddingBallBatchWithSpawnAges_ExpectBallsAdvancedAlongLaunchTrajectory)
+{
+    physics.set_gravity(gravity);
+    physics.set_new_ball_parameters(radius, mass, color, position, velocity, coefficientOfRestitution);
+    float spawnAges[2]{0, 0.5};
+
+    physics.add_balls(2, spawnAges);
+
+    Eigen::Vector3f launchAcceleration{0, 0, gravity};
+    EXPECT_VECTOR3_FLOAT_EQ(physics.get_ball_ptr(0)->position, position);
+    EXPECT_VECTOR3_FLOAT_EQ(physics.get_ball_ptr(1)->position, position + velocity*0.5 + 0.5*launchAcceleration*0.25);
+    EXPECT_VECTOR3_FLOAT_EQ(physics.get_ball_ptr(1)->velocity, velocity + launchAcceleration*0.5);
+}
+
+TEST_F(PhysicsTests, WhenAddingBallBatchPastCapacity_ExpectOldestBallsRecycled)
+{
+    physics.set_max_ball_count(10);
+    std::vector<BallHandle> firstHandles(10);
+    physics.add_balls(10, nullptr, firstHandles.data());
+
+    physics.add_balls(4);
+
+    EXPECT_EQ(physics.get_ball_count(), 10);
+    for(unsigned int index{0}; index < 4; index++)
+        EXPECT_EQ(physics.lookup(firstHandles[index]), -1);
+    EXPECT_EQ(physics.lookup(firstHandles[4]), 4);
+}
+
+TEST_F(PhysicsTests, WhenAddingEmitters_ExpectEmitterCountAndParameters)
+{
+    physics.add_emitter(Emitter(position, Eigen::Vector3f{0, 0, 1}, 10, 50));
+    unsigned int index{physics.add_emitter(Emitter(-position, Eigen::Vector3f{1, 0, 0}, 5, 20))};
+
+    EXPECT_EQ(physics.get_emitter_count(), 2);
+    EXPECT_EQ(index, 1);
+    EXPECT_EQ(physics.get_emitter_ptr(1)->get_speed(), 5);
+}
+
+TEST_F(PhysicsTests, WhenUpdatingWithEmitters_ExpectAllEmittersServiced)
+{
+    physics.set_max_ball_count(1000);
+    physics.add_emitter(Emitter(Eigen::Vector3f{-5, 0, 1}, Eigen::Vector3f{0, 0, 1}, 10, 100));
+    physics.add_emitter(Emitter(Eigen::Vector3f{5, 0, 1}, Eigen::Vector3f{0, 0, 1}, 10, 200));
+
+    for(int step{0}; step < 10; step++)
+        physics.update(0.1);
+
+    EXPECT_NEAR(physics.get_ball_count(), 300, 2);
+}
+
+TEST_F(PhysicsTests, WhenRemovingEmitter_ExpectNoMoreBallsFromIt)
+{
+    physics.add_emitter(Emitter(position, Eigen::Vector3f{0, 0, 1}, 10, 100));
+    physics.remove_emitter(0);
+
+    physics.update(deltaTime);
+
+    EXPECT_EQ(physics.get_emitter_count(), 0);
+    EXPECT_EQ(physics.get_ball_count(), 0);
+}
+
+TEST_F(PhysicsTests, WhenBallRestsOnFloorPastTimeThreshold_ExpectBallSleeps)
+{
+    physics.set_new_ball_parameters(0.5, mass, color, Eigen::Vector3f{0, 0, 0.5}, Eigen::Vector3f{0, 0, 0}, coefficientOfRestitution);
+    physics.add_ball();
+
+    for(int step{0}; step < 120; step++)
+        physics.update(1.0/120);
+
+    EXPECT_EQ(physics.get_awake_ball_count(), 0);
+    EXPECT_TRUE(physics.is_ball_sleeping(0));
+    EXPECT_VECTOR3_FLOAT_EQ(physics.get_ball_ptr(0)->velocity, Eigen::Vector3f(0, 0, 0));
+    EXPECT_VECTOR3_FLOAT_EQ(physics.get_ball_ptr(0)->previousPosition, physics.get_ball_ptr(0)->position);
+}
+
+TEST_F(PhysicsTests, WhenBallRestsOnFloorBelowTimeThreshold_ExpectBallAwake)
+{
+    physics.set_new_ball_parameters(0.5, mass, color, Eigen::Vector3f{0, 0, 0.5}, Eigen::Vector3f{0, 0, 0}, coefficientOfRestitution);
+    physics.add_ball();
+
+    for(int step{0}; step < 30; step++)
+        physics.update(1.0/120);
+
+    EXPECT_EQ(physics.get_awake_ball_count(), 1);
+    EXPECT_FALSE(physics.is_ball_sleeping(0));
+}
+
+TEST_F(PhysicsTests, WhenBallSlowAtTopOfFlight_ExpectBallAwake)
+{
+    physics.set_new_ball_parameters(0.5, mass, color, Eigen::Vector3f{0, 0, 10}, Eigen::Vector3f{0, 0, 0}, coefficientOfRestitution);
+    physics.add_ball();
+
+    for(int step{0}; step < 60; step++)
+        physics.update(1.0/120);
+
+    EXPECT_EQ(physics.get_awake_ball_count(), 1);
+}
+
+TEST_F(PhysicsTests, WhenSleepingDisabled_ExpectRestingBallAwake)
+{
+    physics.set_sleeping_enabled(false);
+    physics.set_new_ball_parameters(0.5, mass, color, Eigen::Vector3f{0, 0, 0.5}, Eigen::Vector3f{0, 0, 0}, coefficientOfRestitution);
+    physics.add_ball();
+
+    for(int step{0}; step < 120; step++)
+        physics.update(1.0/120);
+
+    EXPECT_FALSE(physics.get_sleeping_enabled());
+    EXPECT_EQ(physics.get_awake_ball_count(), 1);
+}
+
+TEST_F(PhysicsTests, WhenChangingGravityOrBoxSize_ExpectSleepingBallsWoken)
+{
+    physics.set_new_ball_parameters(0.5, mass, color, Eigen::Vector3f{0, 0, 0.5}, Eigen::Vector3f{0, 0, 0}, coefficientOfRestitution);
+    physics.add_ball();
+    for(int step{0}; step < 120; step++)
+        physics.update(1.0/120);
+    ASSERT_EQ(physics.get_awake_ball_count(), 0);
+
+    physics.set_gravity(gravity);
+    EXPECT_EQ(physics.get_awake_ball_count(), 1);
+
+    for(int step{0}; step < 120; step++)
+        physics.update(1.0/120);
+    ASSERT_EQ(physics.get_awake_ball_count(), 0);
+
+    physics.set_box_size(boxSize);
+    EXPECT_EQ(physics.get_awake_ball_count(), 1);
+}
+
+TEST_F(PhysicsTests, WhenSleepingBallsReordered_ExpectHandlesStillValid)
+{
+    physics.set_new_ball_parameters(0.5, mass, color, Eigen::Vector3f{0, 0, 0.5}, Eigen::Vector3f{0, 0, 0}, coefficientOfRestitution);
+    BallHandle restingHandle{physics.add_ball()};
+    physics.set_new_ball_position(Eigen::Vector3f{10, 0, 20});
+    BallHandle fallingHandle{physics.add_ball()};
+
+    for(int step{0}; step < 120; step++)
+        physics.update(1.0/120);
+
+    ASSERT_EQ(physics.get_awake_ball_count(), 1);
+    EXPECT_TRUE(physics.is_ball_sleeping(physics.lookup(restingHandle)));
+    EXPECT_FALSE(physics.is_ball_sleeping(physics.lookup(fallingHandle)));
+    EXPECT_FLOAT_EQ(physics.get_ball_ptr(physics.lookup(restingHandle))->position[0], 0);
+    EXPECT_FLOAT_EQ(physics.get_ball_ptr(physics.lookup(fallingHandle))->position[0], 10);
+}
+
+TEST_F(PhysicsTests, WhenFastBallHitsSleepingIsland_ExpectWholeIslandWoken)
+{
+    physics.set_new_ball_parameters(0.5, mass, color, Eigen::Vector3f{0, 0, 0.5}, Eigen::Vector3f{0, 0, 0}, coefficientOfRestitution);
+    physics.add_ball();
+    physics.set_new_ball_position(Eigen::Vector3f{1, 0, 0.5});
+    physics.add_ball();
+    for(int step{0}; step < 120; step++)
+        physics.update(1.0/120);
+    ASSERT_EQ(physics.get_awake_ball_count(), 0);
+
+    physics.set_new_ball_position(Eigen::Vector3f{-3, 0, 0.5});
+    physics.set_new_ball_velocity(Eigen::Vector3f{20, 0, 0});
+    physics.add_ball();
+    for(int step{0}; step < 30; step++)
+        physics.update(1.0/120);
+
+    EXPECT_EQ(physics.get_awake_ball_count(), 3);
+}
+
+TEST_F(PhysicsTests, WhenSlowBallSettlesOnSleepingIsland_ExpectIslandStaysAsleep)
+{
+    physics.set_new_ball_parameters(0.5, mass, color, Eigen::Vector3f{0, 0, 0.5}, Eigen::Vector3f{0, 0, 0}, coefficientOfRestitution);
+    physics.add_ball();
+    for(int step{0}; step < 120; step++)
+        physics.update(1.0/120);
+    ASSERT_EQ(physics.get_awake_ball_count(), 0);
+
+    physics.set_new_ball_position(Eigen::Vector3f{1, 0, 0.5});
+    physics.add_ball();
+    for(int step{0}; step < 120; step++)
+        physics.update(1.0/120);
+
+    EXPECT_EQ(physics.get_awake_ball_count(), 0);
+}
+
+TEST_F(PhysicsTests, WhenRemovingSleepingBall_ExpectItsIslandWoken)
+{
+    physics.set_new_ball_parameters(0.5, mass, color, Eigen::Vector3f{0, 0, 0.5}, Eigen::Vector3f{0, 0, 0}, coefficientOfRestitution);
+    BallHandle handle{physics.add_ball()};
+    physics.set_new_ball_position(Eigen::Vector3f{1, 0, 0.5});
+    physics.add_ball();
+    physics.set_new_ball_position(Eigen::Vector3f{10, 0, 0.5});
+    physics.add_ball();
+    for(int step{0}; step < 120; step++)
+        physics.update(1.0/120);
+    ASSERT_EQ(physics.get_awake_ball_count(), 0);
+
+    EXPECT_TRUE(physics.remove_ball(handle));
+
+    EXPECT_EQ(physics.get_ball_count(), 2);
+    EXPECT_EQ(physics.get_awake_ball_count(), 1);
+    EXPECT_FLOAT_EQ(physics.get_ball_ptr(0)->position[0], 1);
+}
+
+TEST_F(PhysicsTests, WhenSelectingBroadphase_ExpectTypeReported)
+{
+    EXPECT_EQ(physics.get_broadphase_type(), spatialHashBroadphase);
+
+    physics.set_broadphase_type(sweepAndPruneBroadphase);
+
+    EXPECT_EQ(physics.get_broadphase_type(), sweepAndPruneBroadphase);
+}
+
+TEST_F(PhysicsTests, WhenOverlappingBallsStepWithEachBroadphase_ExpectBallsPushedApart)
+{
+    BroadphaseType types[]{bruteForceBroadphase, spatialHashBroadphase, sweepAndPruneBroadphase};
+    for(BroadphaseType type : types)
+    {
+        BallPhysics overlapping;
+        overlapping.set_broadphase_type(type);
+        overlapping.set_gravity(0);
+        overlapping.set_new_ball_parameters(1, mass, color, Eigen::Vector3f{0, 0, 5}, Eigen::Vector3f{0, 0, 0}, coefficientOfRestitution);
+        overlapping.add_ball();
+        overlapping.set_new_ball_position(Eigen::Vector3f{1, 0, 5});
+        overlapping.add_ball();
+
+        overlapping.update(1.0/120);
+
+        Eigen::Vector3f firstPosition{overlapping.get_ball_ptr(0)->position};
+        Eigen::Vector3f secondPosition{overlapping.get_ball_ptr(1)->position};
+        float distance{(firstPosition - secondPosition).norm()};
+        EXPECT_NEAR(distance, 2, 1e-4) << "broadphase " << type;
+    }
+}
+
+TEST_F(PhysicsTests, WhenRestoringStateWithSweepAndPrune_ExpectIdenticalSteps)
+{
+    BallPhysics fountain(10, 1.2, -9.81, 400);
+    fountain.set_broadphase_type(sweepAndPruneBroadphase);
+    fountain.set_thread_count(2);
+    fountain.add_emitter(Emitter(Eigen::Vector3f{0, 0, 0.5}, Eigen::Vector3f{0, 0, 1}, 15, 400));
+    for(int step{0}; step < 120; step++)
+        fountain.update(1.0/120);
+    BallPhysicsState state;
+    fountain.save_state(state);
+    for(int step{0}; step < 60; step++)
+        fountain.update(1.0/120);
+    std::vector<Eigen::Vector3f> expectedPositions;
+    for(unsigned int ballIndex{0}; ballIndex < fountain.get_ball_count(); ballIndex++)
+        expectedPositions.push_back(fountain.get_ball_ptr(ballIndex)->position);
+
+    fountain.restore_state(state);
+    for(int step{0}; step < 60; step++)
+        fountain.update(1.0/120);
+
+    ASSERT_EQ(fountain.get_ball_count(), expectedPositions.size());
+    for(unsigned int ballIndex{0}; ballIndex < fountain.get_ball_count(); ballIndex++)
+        EXPECT_EQ(Eigen::Vector3f{fountain.get_ball_ptr(ballIndex)->position}, expectedPositions[ballIndex]);
+}
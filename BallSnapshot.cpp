@@ -0,0 +1,72 @@
+#include "BallSnapshot.hpp"
+#include <algorithm>
+
+
+void BallSnapshot::reserve(unsigned int capacity)
+{
+    positionX.reserve(capacity);
+    positionY.reserve(capacity);
+    positionZ.reserve(capacity);
+    previousPositionX.reserve(capacity);
+    previousPositionY.reserve(capacity);
+    previousPositionZ.reserve(capacity);
+    radius.reserve(capacity);
+    color.reserve(capacity);
+    revision.reserve(capacity);
+}
+
+void BallSnapshot::copy_from(const BallStorage &balls, unsigned int count, unsigned long step)
+{
+    ballCount = count;
+    stepCount = step;
+    positionX.assign(balls.positionX.begin(), balls.positionX.begin() + count);
+    positionY.assign(balls.positionY.begin(), balls.positionY.begin() + count);
+    positionZ.assign(balls.positionZ.begin(), balls.positionZ.begin() + count);
+    previousPositionX.assign(balls.previousPositionX.begin(), balls.previousPositionX.begin() + count);
+    previousPositionY.assign(balls.previousPositionY.begin(), balls.previousPositionY.begin() + count);
+    previousPositionZ.assign(balls.previousPositionZ.begin(), balls.previousPositionZ.begin() + count);
+    radius.assign(balls.radius.begin(), balls.radius.begin() + count);
+    color.assign(balls.color.begin(), balls.color.begin() + count);
+    revision.assign(balls.revision.begin(), balls.revision.begin() + count);
+}
+
+Eigen::Vector3f BallSnapshot::get_interpolated_position(unsigned int index, float alpha) const
+{
+    Eigen::Vector3f previousPosition{previousPositionX[index], previousPositionY[index], previousPositionZ[index]};
+    Eigen::Vector3f position{positionX[index], positionY[index], positionZ[index]};
+    return previousPosition + alpha*(position - previousPosition);
+}
+
+SnapshotTripleBuffer::SnapshotTripleBuffer() :
+    middleIndex{1}
+{
+}
+
+void SnapshotTripleBuffer::reserve(unsigned int capacity)
+{
+    for(BallSnapshot &buffer : buffers)
+        buffer.reserve(capacity);
+}
+
+BallSnapshot& SnapshotTripleBuffer::get_back()
+{
+    return buffers[backIndex];
+}
+
+void SnapshotTripleBuffer::publish()
+{
+    backIndex = middleIndex.exchange(backIndex | freshFlag, std::memory_order_acq_rel) & indexMask;
+}
+
+bool SnapshotTripleBuffer::acquire_latest()
+{
+    if(!(middleIndex.load(std::memory_order_relaxed) & freshFlag))
+        return false;
+    frontIndex = middleIndex.exchange(frontIndex, std::memory_order_acq_rel) & indexMask;
+    return true;
+}
+
+const BallSnapshot& SnapshotTripleBuffer::get_front() const
+{
+    return buffers[frontIndex];
+}
@@ -0,0 +1,52 @@
+#ifndef BALL_SNAPSHOT_HPP
+#define BALL_SNAPSHOT_HPP
+
+#include "BallStorage.hpp"
+#include <atomic>
+
+
+struct BallSnapshot
+{
+    void reserve(unsigned int capacity);
+    void copy_from(const BallStorage &balls, unsigned int count, unsigned long step);
+    Eigen::Vector3f get_interpolated_position(unsigned int index, float alpha) const;
+
+    unsigned int ballCount{0};
+    unsigned long stepCount{0};
+    unsigned int restoreCount{0};
+    AlignedVector<float> positionX;
+    AlignedVector<float> positionY;
+    AlignedVector<float> positionZ;
+    AlignedVector<float> previousPositionX;
+    AlignedVector<float> previousPositionY;
+    AlignedVector<float> previousPositionZ;
+    AlignedVector<float> radius;
+    AlignedVector<unsigned int> color;
+    AlignedVector<unsigned int> revision;
+};
+
+// Single-producer/single-consumer triple buffer. The writer fills the back
+// buffer and swaps it with the middle one; the reader swaps the middle one
+// into the front only when it holds a newer snapshot. Neither side waits.
+class SnapshotTripleBuffer
+{
+public:
+    SnapshotTripleBuffer();
+
+    void reserve(unsigned int capacity);
+    BallSnapshot& get_back();
+    void publish();
+    bool acquire_latest();
+    const BallSnapshot& get_front() const;
+
+private:
+    static const unsigned int freshFlag{4};
+    static const unsigned int indexMask{3};
+
+    BallSnapshot buffers[3];
+    unsigned int backIndex{0};
+    std::atomic<unsigned int> middleIndex;
+    unsigned int frontIndex{2};
+};
+
+#endif
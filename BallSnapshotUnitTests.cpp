@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+#include "UnitTestUtils.hpp"
+#include "BallSnapshot.hpp"
+
+#include <thread>
+
+
+class BallSnapshotTests : public ::testing::Test
+{
+protected:
+    void write_snapshot(unsigned int count, unsigned long step);
+    SnapshotTripleBuffer snapshots;
+    BallStorage balls;
+};
+
+void BallSnapshotTests::write_snapshot(unsigned int count, unsigned long step)
+{
+    snapshots.get_back().copy_from(balls, count, step);
+    snapshots.publish();
+}
+
+TEST_F(BallSnapshotTests, WhenCopyingFromStorage_ExpectSameRenderState)
+{
+    balls.push_back(Ball(2, 4, 120, Eigen::Vector3f{1, 2, 3}, Eigen::Vector3f{0, 0, 0}, Eigen::Vector3f{0, 0, 0}, 0.5));
+    BallSnapshot snapshot;
+
+    snapshot.copy_from(balls, 1, 7);
+
+    EXPECT_EQ(snapshot.ballCount, 1);
+    EXPECT_EQ(snapshot.stepCount, 7);
+    EXPECT_EQ(snapshot.radius[0], 2);
+    EXPECT_EQ(snapshot.color[0], 120);
+    EXPECT_VECTOR3_FLOAT_EQ(snapshot.get_interpolated_position(0, 0.5), Eigen::Vector3f{1, 2, 3});
+}
+
+TEST_F(BallSnapshotTests, WhenNothingPublished_ExpectNoNewSnapshotAndEmptyFront)
+{
+    EXPECT_FALSE(snapshots.acquire_latest());
+    EXPECT_EQ(snapshots.get_front().ballCount, 0);
+}
+
+TEST_F(BallSnapshotTests, WhenPublishingSeveralTimes_ExpectReaderSeesNewestOnce)
+{
+    write_snapshot(0, 1);
+    write_snapshot(0, 2);
+
+    EXPECT_TRUE(snapshots.acquire_latest());
+    EXPECT_EQ(snapshots.get_front().stepCount, 2);
+    EXPECT_FALSE(snapshots.acquire_latest());
+    EXPECT_EQ(snapshots.get_front().stepCount, 2);
+}
+
+TEST_F(BallSnapshotTests, WhenWriterAndReaderRunConcurrently_ExpectMonotonicCompleteSnapshots)
+{
+    for(int count{0}; count < 64; count++)
+        balls.push_back(Ball());
+    snapshots.reserve(64);
+    unsigned long lastStep{20000};
+
+    std::thread writer([this, lastStep]
+    {
+        for(unsigned long step{1}; step <= lastStep; step++)
+        {
+            for(unsigned int index{0}; index < balls.size(); index++)
+                balls.positionX[index] = step;
+            write_snapshot(balls.size(), step);
+        }
+    });
+
+    unsigned long seenStep{0};
+    bool consistent{true};
+    while(seenStep < lastStep)
+    {
+        if(!snapshots.acquire_latest())
+            continue;
+        const BallSnapshot &snapshot = snapshots.get_front();
+        consistent = consistent && snapshot.stepCount > seenStep;
+        for(unsigned int index{0}; index < snapshot.ballCount; index++)
+            consistent = consistent && snapshot.positionX[index] == snapshot.stepCount;
+        seenStep = snapshot.stepCount;
+    }
+    writer.join();
+
+    EXPECT_TRUE(consistent);
+}
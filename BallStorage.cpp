@@ -0,0 +1,236 @@
+#include "BallStorage.hpp"
+#include <algorithm>
+#include <utility>
+
+
+void BallStorage::reserve(unsigned int capacity)
+{
+    positionX.reserve(capacity);
+    positionY.reserve(capacity);
+    positionZ.reserve(capacity);
+    previousPositionX.reserve(capacity);
+    previousPositionY.reserve(capacity);
+    previousPositionZ.reserve(capacity);
+    velocityX.reserve(capacity);
+    velocityY.reserve(capacity);
+    velocityZ.reserve(capacity);
+    accelerationX.reserve(capacity);
+    accelerationY.reserve(capacity);
+    accelerationZ.reserve(capacity);
+    radius.reserve(capacity);
+    mass.reserve(capacity);
+    inverseMass.reserve(capacity);
+    dragConstant.reserve(capacity);
+    coefficientOfRestitution.reserve(capacity);
+    color.reserve(capacity);
+    revision.reserve(capacity);
+    sleepTime.reserve(capacity);
+}
+
+void BallStorage::push_back(const Ball &ball)
+{
+    positionX.push_back(0);
+    positionY.push_back(0);
+    positionZ.push_back(0);
+    previousPositionX.push_back(0);
+    previousPositionY.push_back(0);
+    previousPositionZ.push_back(0);
+    velocityX.push_back(0);
+    velocityY.push_back(0);
+    velocityZ.push_back(0);
+    accelerationX.push_back(0);
+    accelerationY.push_back(0);
+    accelerationZ.push_back(0);
+    radius.push_back(0);
+    mass.push_back(0);
+    inverseMass.push_back(0);
+    dragConstant.push_back(0);
+    coefficientOfRestitution.push_back(0);
+    color.push_back(0);
+    revision.push_back(0);
+    sleepTime.push_back(0);
+    set(size() - 1, ball);
+}
+
+void BallStorage::pop_back()
+{
+    positionX.pop_back();
+    positionY.pop_back();
+    positionZ.pop_back();
+    previousPositionX.pop_back();
+    previousPositionY.pop_back();
+    previousPositionZ.pop_back();
+    velocityX.pop_back();
+    velocityY.pop_back();
+    velocityZ.pop_back();
+    accelerationX.pop_back();
+    accelerationY.pop_back();
+    accelerationZ.pop_back();
+    radius.pop_back();
+    mass.pop_back();
+    inverseMass.pop_back();
+    dragConstant.pop_back();
+    coefficientOfRestitution.pop_back();
+    color.pop_back();
+    revision.pop_back();
+    sleepTime.pop_back();
+}
+
+void BallStorage::clear()
+{
+    positionX.clear();
+    positionY.clear();
+    positionZ.clear();
+    previousPositionX.clear();
+    previousPositionY.clear();
+    previousPositionZ.clear();
+    velocityX.clear();
+    velocityY.clear();
+    velocityZ.clear();
+    accelerationX.clear();
+    accelerationY.clear();
+    accelerationZ.clear();
+    radius.clear();
+    mass.clear();
+    inverseMass.clear();
+    dragConstant.clear();
+    coefficientOfRestitution.clear();
+    color.clear();
+    revision.clear();
+    sleepTime.clear();
+}
+
+void BallStorage::set(unsigned int index, const Ball &ball)
+{
+    set_position(index, ball.position);
+    previousPositionX[index] = ball.position[0];
+    previousPositionY[index] = ball.position[1];
+    previousPositionZ[index] = ball.position[2];
+    set_velocity(index, ball.velocity);
+    accelerationX[index] = ball.acceleration[0];
+    accelerationY[index] = ball.acceleration[1];
+    accelerationZ[index] = ball.acceleration[2];
+    radius[index] = ball.radius;
+    mass[index] = ball.mass;
+    inverseMass[index] = ball.mass > 0 ? 1/ball.mass : 0;
+    coefficientOfRestitution[index] = ball.coefficientOfRestitution;
+    color[index] = ball.color;
+    sleepTime[index] = 0;
+}
+
+void BallStorage::swap(unsigned int firstIndex, unsigned int secondIndex)
+{
+    std::swap(positionX[firstIndex], positionX[secondIndex]);
+    std::swap(positionY[firstIndex], positionY[secondIndex]);
+    std::swap(positionZ[firstIndex], positionZ[secondIndex]);
+    std::swap(previousPositionX[firstIndex], previousPositionX[secondIndex]);
+    std::swap(previousPositionY[firstIndex], previousPositionY[secondIndex]);
+    std::swap(previousPositionZ[firstIndex], previousPositionZ[secondIndex]);
+    std::swap(velocityX[firstIndex], velocityX[secondIndex]);
+    std::swap(velocityY[firstIndex], velocityY[secondIndex]);
+    std::swap(velocityZ[firstIndex], velocityZ[secondIndex]);
+    std::swap(accelerationX[firstIndex], accelerationX[secondIndex]);
+    std::swap(accelerationY[firstIndex], accelerationY[secondIndex]);
+    std::swap(accelerationZ[firstIndex], accelerationZ[secondIndex]);
+    std::swap(radius[firstIndex], radius[secondIndex]);
+    std::swap(mass[firstIndex], mass[secondIndex]);
+    std::swap(inverseMass[firstIndex], inverseMass[secondIndex]);
+    std::swap(dragConstant[firstIndex], dragConstant[secondIndex]);
+    std::swap(coefficientOfRestitution[firstIndex], coefficientOfRestitution[secondIndex]);
+    std::swap(color[firstIndex], color[secondIndex]);
+    std::swap(revision[firstIndex], revision[secondIndex]);
+    std::swap(sleepTime[firstIndex], sleepTime[secondIndex]);
+}
+
+Ball BallStorage::get(unsigned int index) const
+{
+    Eigen::Vector3f acceleration{accelerationX[index], accelerationY[index], accelerationZ[index]};
+    return Ball(radius[index], mass[index], color[index], get_position(index), get_velocity(index), acceleration, coefficientOfRestitution[index]);
+}
+
+unsigned int BallStorage::size() const
+{
+    return positionX.size();
+}
+
+Eigen::Vector3f BallStorage::get_position(unsigned int index) const
+{
+    return Eigen::Vector3f{positionX[index], positionY[index], positionZ[index]};
+}
+
+Eigen::Vector3f BallStorage::get_velocity(unsigned int index) const
+{
+    return Eigen::Vector3f{velocityX[index], velocityY[index], velocityZ[index]};
+}
+
+Eigen::Vector3f BallStorage::get_interpolated_position(unsigned int index, float alpha) const
+{
+    Eigen::Vector3f previousPosition{previousPositionX[index], previousPositionY[index], previousPositionZ[index]};
+    return previousPosition + alpha*(get_position(index) - previousPosition);
+}
+
+void BallStorage::store_previous_positions(unsigned int firstIndex, unsigned int lastIndex)
+{
+    std::copy(positionX.begin() + firstIndex, positionX.begin() + lastIndex, previousPositionX.begin() + firstIndex);
+    std::copy(positionY.begin() + firstIndex, positionY.begin() + lastIndex, previousPositionY.begin() + firstIndex);
+    std::copy(positionZ.begin() + firstIndex, positionZ.begin() + lastIndex, previousPositionZ.begin() + firstIndex);
+}
+
+void BallStorage::set_position(unsigned int index, const Eigen::Vector3f &position)
+{
+    positionX[index] = position[0];
+    positionY[index] = position[1];
+    positionZ[index] = position[2];
+}
+
+void BallStorage::set_velocity(unsigned int index, const Eigen::Vector3f &velocity)
+{
+    velocityX[index] = velocity[0];
+    velocityY[index] = velocity[1];
+    velocityZ[index] = velocity[2];
+}
+
+BallVectorView::BallVectorView(const float &xInit, const float &yInit, const float &zInit) :
+    x{xInit},
+    y{yInit},
+    z{zInit}
+{
+}
+
+float BallVectorView::operator[](int index) const
+{
+    return index == 0 ? x : (index == 1 ? y : z);
+}
+
+BallVectorView::operator Eigen::Vector3f() const
+{
+    return Eigen::Vector3f{x, y, z};
+}
+
+BallView::BallView(const BallStorage &storage, unsigned int index) :
+    radius{storage.radius[index]},
+    mass{storage.mass[index]},
+    color{storage.color[index]},
+    position{storage.positionX[index], storage.positionY[index], storage.positionZ[index]},
+    previousPosition{storage.previousPositionX[index], storage.previousPositionY[index], storage.previousPositionZ[index]},
+    velocity{storage.velocityX[index], storage.velocityY[index], storage.velocityZ[index]},
+    acceleration{storage.accelerationX[index], storage.accelerationY[index], storage.accelerationZ[index]},
+    coefficientOfRestitution{storage.coefficientOfRestitution[index]},
+    revision{storage.revision[index]}
+{
+}
+
+BallPtr::BallPtr(const BallStorage &storage, unsigned int index) :
+    view{storage, index}
+{
+}
+
+const BallView* BallPtr::operator->() const
+{
+    return &view;
+}
+
+const BallView& BallPtr::operator*() const
+{
+    return view;
+}
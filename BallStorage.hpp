@@ -0,0 +1,86 @@
+#ifndef BALL_STORAGE_HPP
+#define BALL_STORAGE_HPP
+
+#include "Ball.hpp"
+#include "AlignedAllocator.hpp"
+#include <eigen3/Eigen/Dense>
+
+
+struct BallStorage
+{
+    void reserve(unsigned int capacity);
+    void push_back(const Ball &ball);
+    void pop_back();
+    void clear();
+    void set(unsigned int index, const Ball &ball);
+    void swap(unsigned int firstIndex, unsigned int secondIndex);
+    Ball get(unsigned int index) const;
+    unsigned int size() const;
+
+    Eigen::Vector3f get_position(unsigned int index) const;
+    Eigen::Vector3f get_velocity(unsigned int index) const;
+    Eigen::Vector3f get_interpolated_position(unsigned int index, float alpha) const;
+    void store_previous_positions(unsigned int firstIndex, unsigned int lastIndex);
+    void set_position(unsigned int index, const Eigen::Vector3f &position);
+    void set_velocity(unsigned int index, const Eigen::Vector3f &velocity);
+
+    AlignedVector<float> positionX;
+    AlignedVector<float> positionY;
+    AlignedVector<float> positionZ;
+    AlignedVector<float> previousPositionX;
+    AlignedVector<float> previousPositionY;
+    AlignedVector<float> previousPositionZ;
+    AlignedVector<float> velocityX;
+    AlignedVector<float> velocityY;
+    AlignedVector<float> velocityZ;
+    AlignedVector<float> accelerationX;
+    AlignedVector<float> accelerationY;
+    AlignedVector<float> accelerationZ;
+    AlignedVector<float> radius;
+    AlignedVector<float> mass;
+    AlignedVector<float> inverseMass;
+    AlignedVector<float> dragConstant;
+    AlignedVector<float> coefficientOfRestitution;
+    AlignedVector<unsigned int> color;
+    AlignedVector<unsigned int> revision;
+    AlignedVector<float> sleepTime;
+};
+
+struct BallVectorView
+{
+    BallVectorView(const float &xInit, const float &yInit, const float &zInit);
+    float operator[](int index) const;
+    operator Eigen::Vector3f() const;
+
+    const float &x;
+    const float &y;
+    const float &z;
+};
+
+struct BallView
+{
+    BallView(const BallStorage &storage, unsigned int index);
+
+    const float &radius;
+    const float &mass;
+    const unsigned int &color;
+    BallVectorView position;
+    BallVectorView previousPosition;
+    BallVectorView velocity;
+    BallVectorView acceleration;
+    const float &coefficientOfRestitution;
+    const unsigned int &revision;
+};
+
+class BallPtr
+{
+public:
+    BallPtr(const BallStorage &storage, unsigned int index);
+    const BallView* operator->() const;
+    const BallView& operator*() const;
+
+private:
+    BallView view;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "gtest/gtest.h"
+#include "UnitTestUtils.hpp"
+#include "BallStorage.hpp"
+
+#include <cstdint>
+
+
+class BallStorageTests : public ::testing::Test
+{
+protected:
+    BallStorage storage;
+    Ball ball{Ball(10, 4, 128, Eigen::Vector3f{1, 2, 3}, Eigen::Vector3f{4, 5, 6}, Eigen::Vector3f{7, 8, 9}, 0.5)};
+};
+
+TEST_F(BallStorageTests, WhenPushingBall_ExpectSameBallReturned)
+{
+    storage.push_back(ball);
+
+    Ball storedBall = storage.get(0);
+    EXPECT_EQ(storage.size(), 1);
+    EXPECT_EQ(storedBall.radius, ball.radius);
+    EXPECT_EQ(storedBall.mass, ball.mass);
+    EXPECT_EQ(storedBall.color, ball.color);
+    EXPECT_VECTOR3_FLOAT_EQ(storedBall.position, ball.position);
+    EXPECT_VECTOR3_FLOAT_EQ(storedBall.velocity, ball.velocity);
+    EXPECT_VECTOR3_FLOAT_EQ(storedBall.acceleration, ball.acceleration);
+    EXPECT_EQ(storedBall.coefficientOfRestitution, ball.coefficientOfRestitution);
+}
+
+TEST_F(BallStorageTests, WhenPushingBall_ExpectInverseMass)
+{
+    storage.push_back(ball);
+
+    EXPECT_EQ(storage.inverseMass[0], 0.25);
+}
+
+TEST_F(BallStorageTests, WhenReservingStorage_ExpectCacheLineAlignedArrays)
+{
+    storage.reserve(100);
+    storage.push_back(ball);
+
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(storage.positionX.data()) % 64, 0);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(storage.velocityZ.data()) % 64, 0);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(storage.radius.data()) % 64, 0);
+}
+
+TEST_F(BallStorageTests, WhenModifyingStorage_ExpectBallPointerViewReflectsChange)
+{
+    storage.push_back(ball);
+    BallPtr ballPtr(storage, 0);
+    Eigen::Vector3f newPosition{-1, -2, -3};
+
+    storage.set_position(0, newPosition);
+
+    EXPECT_VECTOR3_FLOAT_EQ(ballPtr->position, newPosition);
+    EXPECT_EQ(ballPtr->position[2], newPosition[2]);
+    EXPECT_EQ(ballPtr->radius, ball.radius);
+}
+
+TEST_F(BallStorageTests, WhenPoppingBall_ExpectReducedSize)
+{
+    storage.push_back(ball);
+    storage.push_back(ball);
+
+    storage.pop_back();
+
+    EXPECT_EQ(storage.size(), 1);
+}
@@ -0,0 +1,34 @@
+#ifndef BROADPHASE_HPP
+#define BROADPHASE_HPP
+
+#include "BallStorage.hpp"
+#include <vector>
+
+struct BallPair
+{
+    unsigned int first;
+    unsigned int second;
+};
+
+enum BroadphaseType
+{
+    bruteForceBroadphase,
+    spatialHashBroadphase,
+    sweepAndPruneBroadphase
+};
+
+// Finds the ball pairs that may be touching. Every pair has first < second
+// and at least first below activeCount, so pairs between two inactive balls
+// are never reported. A pair may be a near miss; the narrowphase checks the
+// actual overlap. For the same balls the pairs come out in the same order
+// no matter what was built before, which keeps stepping deterministic.
+class Broadphase
+{
+public:
+    virtual ~Broadphase() {}
+    virtual void reserve(unsigned int capacity) = 0;
+    virtual void build(const BallStorage &balls, unsigned int ballCount, float boxBoundSize) = 0;
+    virtual void find_pairs(std::vector<BallPair> &pairs, unsigned int activeCount) = 0;
+};
+
+#endif
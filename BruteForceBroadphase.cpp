@@ -0,0 +1,36 @@
+#include "BruteForceBroadphase.hpp"
+#include <algorithm>
+
+
+void BruteForceBroadphase::reserve(unsigned int /*capacity*/)
+{
+}
+
+void BruteForceBroadphase::build(const BallStorage &storage, unsigned int count, float /*boxBoundSize*/)
+{
+    this->ballCount = count;
+    this->balls = &storage;
+}
+
+void BruteForceBroadphase::find_pairs(std::vector<BallPair> &pairs, unsigned int activeCount)
+{
+    pairs.clear();
+    if(ballCount == 0)
+        return;
+    const float *positionX{balls->positionX.data()};
+    const float *positionY{balls->positionY.data()};
+    const float *positionZ{balls->positionZ.data()};
+    const float *radius{balls->radius.data()};
+    for(unsigned int ballIndex{0}; ballIndex < std::min(activeCount, ballCount); ballIndex++)
+    {
+        for(unsigned int candidateIndex{ballIndex + 1}; candidateIndex < ballCount; candidateIndex++)
+        {
+            float offsetX{positionX[candidateIndex] - positionX[ballIndex]};
+            float offsetY{positionY[candidateIndex] - positionY[ballIndex]};
+            float offsetZ{positionZ[candidateIndex] - positionZ[ballIndex]};
+            float radiusSum{radius[ballIndex] + radius[candidateIndex]};
+            if(offsetX*offsetX + offsetY*offsetY + offsetZ*offsetZ < radiusSum*radiusSum)
+                pairs.push_back(BallPair{ballIndex, candidateIndex});
+        }
+    }
+}
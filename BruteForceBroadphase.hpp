@@ -0,0 +1,23 @@
+#ifndef BRUTE_FORCE_BROADPHASE_HPP
+#define BRUTE_FORCE_BROADPHASE_HPP
+
+#include "Broadphase.hpp"
+#include <vector>
+
+// Tests every active ball against every later ball. Quadratic, but exact and
+// simple enough to check the faster broadphases against and to benchmark
+// them by. It reads the balls in place, so they must not change between
+// build and find_pairs.
+class BruteForceBroadphase : public Broadphase
+{
+public:
+    void reserve(unsigned int capacity);
+    void build(const BallStorage &balls, unsigned int ballCount, float boxBoundSize);
+    void find_pairs(std::vector<BallPair> &pairs, unsigned int activeCount);
+
+protected:
+    unsigned int ballCount{0};
+    const BallStorage *balls{nullptr};
+};
+
+#endif
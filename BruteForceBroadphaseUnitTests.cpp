@@ -0,0 +1,51 @@
+#include "gtest/gtest.h"
+#include "BruteForceBroadphase.hpp"
+
+
+class BruteForceBroadphaseTests : public ::testing::Test
+{
+protected:
+    void add_ball(float radius, Eigen::Vector3f position);
+    BruteForceBroadphase broadphase;
+    BallStorage balls;
+    std::vector<BallPair> pairs;
+    float boxSize{30};
+};
+
+void BruteForceBroadphaseTests::add_ball(float radius, Eigen::Vector3f position)
+{
+    Ball ball;
+    ball.radius = radius;
+    ball.position = position;
+    balls.push_back(ball);
+}
+
+TEST_F(BruteForceBroadphaseTests, WhenBallsOverlapOrJustMiss_ExpectOnlyOverlappingPair)
+{
+    add_ball(1, Eigen::Vector3f{0, 0, 1});
+    add_ball(1, Eigen::Vector3f{1.5, 0, 1});
+    add_ball(1, Eigen::Vector3f{1.5, 2.5, 1});
+
+    broadphase.build(balls, balls.size(), boxSize);
+    broadphase.find_pairs(pairs, balls.size());
+
+    ASSERT_EQ(pairs.size(), 1);
+    EXPECT_EQ(pairs[0].first, 0);
+    EXPECT_EQ(pairs[0].second, 1);
+}
+
+TEST_F(BruteForceBroadphaseTests, WhenBothBallsInactive_ExpectPairSkipped)
+{
+    add_ball(1, Eigen::Vector3f{0, 0, 1});
+    add_ball(1, Eigen::Vector3f{1, 0, 1});
+    add_ball(1, Eigen::Vector3f{0, 1, 1});
+
+    broadphase.build(balls, balls.size(), boxSize);
+    broadphase.find_pairs(pairs, 1);
+
+    ASSERT_EQ(pairs.size(), 2);
+    EXPECT_EQ(pairs[0].first, 0);
+    EXPECT_EQ(pairs[0].second, 1);
+    EXPECT_EQ(pairs[1].first, 0);
+    EXPECT_EQ(pairs[1].second, 2);
+}
@@ -0,0 +1,386 @@
+#include "ContactSolver.hpp"
+#include <algorithm>
+
+
+namespace
+{
+const unsigned int wallKeyBase{0xFFFFFFF0};
+
+std::uint64_t make_contact_key(unsigned int firstSlot, unsigned int secondSlot)
+{
+    return std::uint64_t(std::min(firstSlot, secondSlot)) << 32 | std::max(firstSlot, secondSlot);
+}
+
+// The generations of the slots in make_contact_key's order.
+std::uint64_t make_contact_generations(unsigned int firstSlot, unsigned int secondSlot, const unsigned int *slotGenerations)
+{
+    unsigned int lowerSlot{std::min(firstSlot, secondSlot)};
+    unsigned int upperSlot{std::max(firstSlot, secondSlot)};
+    return std::uint64_t(slotGenerations[lowerSlot]) << 32 | slotGenerations[upperSlot];
+}
+
+bool key_less(const CachedContact &cachedContact, std::uint64_t key)
+{
+    return cachedContact.key < key;
+}
+
+bool cached_contact_less(const CachedContact &first, const CachedContact &second)
+{
+    return first.key < second.key;
+}
+}
+
+void ContactSolver::reserve(unsigned int capacity, unsigned int pairCapacity)
+{
+    unsigned int contactCapacity{pairCapacity + 3*capacity};
+    contacts.reserve(contactCapacity);
+    coloredContacts.reserve(contactCapacity);
+    contactColors.reserve(contactCapacity);
+    colorStart.reserve(contactCapacity + 1);
+    cache.reserve(contactCapacity);
+    nextCache.reserve(contactCapacity);
+    ballNextColor.reserve(capacity);
+    velocityX.reserve(capacity);
+    velocityY.reserve(capacity);
+    velocityZ.reserve(capacity);
+    pseudoVelocityX.reserve(capacity);
+    pseudoVelocityY.reserve(capacity);
+    pseudoVelocityZ.reserve(capacity);
+    ballTouched.reserve(capacity);
+}
+
+// Only balls below awakeCount move. Ball pairs must come with the awake ball
+// first, as the broadphase gives them.
+void ContactSolver::solve(BallStorage &balls, const std::vector<BallPair> &pairs, const unsigned int *ballSlots, const unsigned int *slotGenerations, unsigned int count, unsigned int awake, float boxBoundSize, float deltaTime, ThreadPool &threadPool)
+{
+    this->ballCount = count;
+    this->awakeCount = awake;
+    velocityX.assign(balls.velocityX.begin(), balls.velocityX.begin() + ballCount);
+    velocityY.assign(balls.velocityY.begin(), balls.velocityY.begin() + ballCount);
+    velocityZ.assign(balls.velocityZ.begin(), balls.velocityZ.begin() + ballCount);
+    pseudoVelocityX.assign(ballCount, 0);
+    pseudoVelocityY.assign(ballCount, 0);
+    pseudoVelocityZ.assign(ballCount, 0);
+    ballTouched.assign(ballCount, 0);
+
+    contacts.clear();
+    warmStartedCount = 0;
+    add_ball_contacts(balls, pairs, ballSlots, slotGenerations, deltaTime);
+    add_wall_contacts(balls, ballSlots, slotGenerations, boxBoundSize, deltaTime);
+    if(threadPool.get_thread_count() > 1)
+        color_contacts();
+    else
+    {
+        coloredContacts.swap(contacts);
+        colorStart.assign(1, 0);
+        colorStart.push_back(coloredContacts.size());
+    }
+
+    for_each_contact(threadPool, [this](Contact &contact)
+    {
+        apply_impulse(contact, contact.normalImpulse, velocityX.data(), velocityY.data(), velocityZ.data());
+    });
+    for(unsigned int iteration{0}; iteration < iterations; iteration++)
+        for_each_contact(threadPool, [this](Contact &contact)
+        {
+            solve_velocity(contact);
+        });
+    for(unsigned int iteration{0}; iteration < positionIterations; iteration++)
+        for_each_contact(threadPool, [this](Contact &contact)
+        {
+            solve_position(contact);
+        });
+
+    for(unsigned int ballIndex{0}; ballIndex < awakeCount; ballIndex++)
+    {
+        if(!ballTouched[ballIndex])
+            continue;
+        balls.positionX[ballIndex] = balls.previousPositionX[ballIndex] + (velocityX[ballIndex] + pseudoVelocityX[ballIndex])*deltaTime;
+        balls.positionY[ballIndex] = balls.previousPositionY[ballIndex] + (velocityY[ballIndex] + pseudoVelocityY[ballIndex])*deltaTime;
+        balls.positionZ[ballIndex] = balls.previousPositionZ[ballIndex] + (velocityZ[ballIndex] + pseudoVelocityZ[ballIndex])*deltaTime;
+        balls.velocityX[ballIndex] = velocityX[ballIndex];
+        balls.velocityY[ballIndex] = velocityY[ballIndex];
+        balls.velocityZ[ballIndex] = velocityZ[ballIndex];
+    }
+    store_cache();
+}
+
+void ContactSolver::clear_cache()
+{
+    cache.clear();
+}
+
+const std::vector<CachedContact>& ContactSolver::get_cache()
+{
+    return this->cache;
+}
+
+void ContactSolver::restore_cache(const std::vector<CachedContact> &savedCache)
+{
+    cache = savedCache;
+}
+
+unsigned int ContactSolver::get_iterations()
+{
+    return this->iterations;
+}
+
+unsigned int ContactSolver::get_position_iterations()
+{
+    return this->positionIterations;
+}
+
+float ContactSolver::get_position_correction_factor()
+{
+    return this->positionCorrectionFactor;
+}
+
+float ContactSolver::get_penetration_slop()
+{
+    return this->penetrationSlop;
+}
+
+float ContactSolver::get_restitution_threshold()
+{
+    return this->restitutionThreshold;
+}
+
+unsigned int ContactSolver::get_contact_count()
+{
+    return coloredContacts.size();
+}
+
+unsigned int ContactSolver::get_warm_started_count()
+{
+    return this->warmStartedCount;
+}
+
+void ContactSolver::set_iterations(unsigned int newIterations)
+{
+    this->iterations = newIterations;
+}
+
+void ContactSolver::set_position_iterations(unsigned int newIterations)
+{
+    this->positionIterations = newIterations;
+}
+
+void ContactSolver::set_position_correction_factor(float newFactor)
+{
+    this->positionCorrectionFactor = newFactor;
+}
+
+void ContactSolver::set_penetration_slop(float newSlop)
+{
+    this->penetrationSlop = newSlop;
+}
+
+void ContactSolver::set_restitution_threshold(float newThreshold)
+{
+    this->restitutionThreshold = newThreshold;
+}
+
+// startSeparation is how far apart the two were along the normal when the
+// step began. A gap there may close this step but no further; a contact that
+// already touched bounces if it closes faster than the restitution threshold,
+// or with the speed it landed with on the step before.
+void ContactSolver::add_contact(const BallStorage &balls, unsigned int first, unsigned int second, std::uint64_t key, std::uint64_t generations, Eigen::Vector3f normal, float startSeparation, float separation, float coefficientOfRestitution, float deltaTime)
+{
+    if(std::min(startSeparation, separation) >= contactMargin)
+        return;
+    Contact contact;
+    contact.key = key;
+    contact.generations = generations;
+    contact.first = first;
+    contact.second = second;
+    contact.normalX = normal[0];
+    contact.normalY = normal[1];
+    contact.normalZ = normal[2];
+    contact.secondMoves = second < awakeCount;
+    contact.inverseMassFirst = balls.inverseMass[first];
+    contact.inverseMassSecond = contact.secondMoves ? balls.inverseMass[second] : 0;
+    float inverseMassSum{contact.inverseMassFirst + contact.inverseMassSecond};
+    contact.effectiveMass = inverseMassSum > 0 ? 1/inverseMassSum : 0;
+
+    float normalSpeed{velocityX[first]*normal[0] + velocityY[first]*normal[1] + velocityZ[first]*normal[2]};
+    if(contact.secondMoves)
+        normalSpeed -= velocityX[second]*normal[0] + velocityY[second]*normal[1] + velocityZ[second]*normal[2];
+    std::vector<CachedContact>::const_iterator cached{std::lower_bound(cache.begin(), cache.end(), key, key_less)};
+    contact.normalImpulse = 0;
+    float landingBounceSpeed{0};
+    if(cached != cache.end() && cached->key == key && cached->generations == generations)
+    {
+        contact.normalImpulse = cached->normalImpulse;
+        landingBounceSpeed = cached->bounceSpeed;
+        warmStartedCount++;
+    }
+    contact.pseudoImpulse = 0;
+    contact.bounceSpeed = 0;
+
+    bool bouncing{normalSpeed < -restitutionThreshold};
+    if(startSeparation > penetrationSlop)
+    {
+        contact.velocityTarget = -startSeparation/deltaTime;
+        if(bouncing && normalSpeed < contact.velocityTarget)
+            contact.bounceSpeed = -coefficientOfRestitution*normalSpeed;
+    }
+    else
+        contact.velocityTarget = std::max(bouncing ? -coefficientOfRestitution*normalSpeed : 0.0f, landingBounceSpeed);
+    contact.pseudoTarget = positionCorrectionFactor*std::max(-startSeparation - penetrationSlop, 0.0f)/deltaTime;
+
+    ballTouched[first] = 1;
+    if(contact.secondMoves)
+        ballTouched[second] = 1;
+    contacts.push_back(contact);
+}
+
+void ContactSolver::add_ball_contacts(const BallStorage &balls, const std::vector<BallPair> &pairs, const unsigned int *ballSlots, const unsigned int *slotGenerations, float deltaTime)
+{
+    for(const BallPair &pair : pairs)
+    {
+        Eigen::Vector3f positionDifference{balls.get_position(pair.first) - balls.get_position(pair.second)};
+        float distance{positionDifference.norm()};
+        if(distance == 0)
+            continue;
+        Eigen::Vector3f normal{positionDifference/distance};
+        Eigen::Vector3f previousDifference{balls.previousPositionX[pair.first] - balls.previousPositionX[pair.second],
+                                           balls.previousPositionY[pair.first] - balls.previousPositionY[pair.second],
+                                           balls.previousPositionZ[pair.first] - balls.previousPositionZ[pair.second]};
+        float contactDistance{balls.radius[pair.first] + balls.radius[pair.second]};
+        float coefficientOfRestitution{0.5f*(balls.coefficientOfRestitution[pair.first] + balls.coefficientOfRestitution[pair.second])};
+        unsigned int firstSlot{ballSlots[pair.first]};
+        unsigned int secondSlot{ballSlots[pair.second]};
+        add_contact(balls, pair.first, pair.second, make_contact_key(firstSlot, secondSlot), make_contact_generations(firstSlot, secondSlot, slotGenerations), normal,
+                    previousDifference.dot(normal) - contactDistance, distance - contactDistance, coefficientOfRestitution, deltaTime);
+    }
+}
+
+// The floor and the four walls, each a static contact keyed by the ball's
+// slot and the wall.
+void ContactSolver::add_wall_contacts(const BallStorage &balls, const unsigned int *ballSlots, const unsigned int *slotGenerations, float boxBoundSize, float deltaTime)
+{
+    for(unsigned int ballIndex{0}; ballIndex < awakeCount; ballIndex++)
+    {
+        float radius{balls.radius[ballIndex]};
+        float coefficientOfRestitution{balls.coefficientOfRestitution[ballIndex]};
+        std::uint64_t slotKey{std::uint64_t(ballSlots[ballIndex]) << 32 | wallKeyBase};
+        std::uint64_t generations{std::uint64_t(slotGenerations[ballSlots[ballIndex]]) << 32};
+        add_contact(balls, ballIndex, ballCount, slotKey, generations, Eigen::Vector3f{0, 0, 1},
+                    balls.previousPositionZ[ballIndex] - radius, balls.positionZ[ballIndex] - radius, coefficientOfRestitution, deltaTime);
+        const float *position[2]{balls.positionX.data(), balls.positionY.data()};
+        const float *previousPosition[2]{balls.previousPositionX.data(), balls.previousPositionY.data()};
+        for(unsigned int axis{0}; axis < 2; axis++)
+        {
+            for(int side{-1}; side <= 1; side += 2)
+            {
+                Eigen::Vector3f normal{0, 0, 0};
+                normal[axis] = -side;
+                add_contact(balls, ballIndex, ballCount, slotKey + 1 + 2*axis + (side > 0), generations, normal,
+                            boxBoundSize - side*previousPosition[axis][ballIndex] - radius, boxBoundSize - side*position[axis][ballIndex] - radius,
+                            coefficientOfRestitution, deltaTime);
+            }
+        }
+    }
+}
+
+// Same coloring as BallPhysics::color_collision_pairs. Static partners are
+// never written, so they do not constrain the color.
+void ContactSolver::color_contacts()
+{
+    ballNextColor.assign(ballCount, 0);
+    contactColors.resize(contacts.size());
+    colorStart.assign(1, 0);
+    for(unsigned int contactIndex{0}; contactIndex < contacts.size(); contactIndex++)
+    {
+        const Contact &contact = contacts[contactIndex];
+        unsigned int color{ballNextColor[contact.first]};
+        if(contact.secondMoves)
+            color = std::max(color, ballNextColor[contact.second]);
+        ballNextColor[contact.first] = color + 1;
+        if(contact.secondMoves)
+            ballNextColor[contact.second] = color + 1;
+        contactColors[contactIndex] = color;
+        if(color + 1 >= colorStart.size())
+            colorStart.resize(color + 2, 0);
+        colorStart[color]++;
+    }
+
+    for(unsigned int color{1}; color < colorStart.size(); color++)
+        colorStart[color] += colorStart[color - 1];
+
+    coloredContacts.resize(contacts.size());
+    for(unsigned int contactIndex{(unsigned int)contacts.size()}; contactIndex-- > 0;)
+        coloredContacts[--colorStart[contactColors[contactIndex]]] = contacts[contactIndex];
+}
+
+template<typename Function>
+void ContactSolver::for_each_contact(ThreadPool &threadPool, const Function &function)
+{
+    for(unsigned int color{0}; color + 1 < colorStart.size(); color++)
+    {
+        unsigned int firstContact{colorStart[color]};
+        unsigned int lastContact{colorStart[color + 1]};
+        if(lastContact - firstContact <= contactsPerTask)
+        {
+            for(unsigned int contactIndex{firstContact}; contactIndex < lastContact; contactIndex++)
+                function(coloredContacts[contactIndex]);
+            continue;
+        }
+        unsigned int taskCount{(lastContact - firstContact + contactsPerTask - 1)/contactsPerTask};
+        threadPool.parallel_for(taskCount, [this, &function, firstContact, lastContact](unsigned int taskIndex)
+        {
+            unsigned int taskStart{firstContact + taskIndex*contactsPerTask};
+            unsigned int taskEnd{std::min(taskStart + contactsPerTask, lastContact)};
+            for(unsigned int contactIndex{taskStart}; contactIndex < taskEnd; contactIndex++)
+                function(coloredContacts[contactIndex]);
+        });
+    }
+}
+
+void ContactSolver::apply_impulse(const Contact &contact, float impulse, float *velocityX, float *velocityY, float *velocityZ)
+{
+    float firstScale{impulse*contact.inverseMassFirst};
+    velocityX[contact.first] += firstScale*contact.normalX;
+    velocityY[contact.first] += firstScale*contact.normalY;
+    velocityZ[contact.first] += firstScale*contact.normalZ;
+    if(!contact.secondMoves)
+        return;
+    float secondScale{impulse*contact.inverseMassSecond};
+    velocityX[contact.second] -= secondScale*contact.normalX;
+    velocityY[contact.second] -= secondScale*contact.normalY;
+    velocityZ[contact.second] -= secondScale*contact.normalZ;
+}
+
+// The accumulated impulse may shrink within a step but never pulls.
+void ContactSolver::solve_velocity(Contact &contact)
+{
+    float normalSpeed{velocityX[contact.first]*contact.normalX + velocityY[contact.first]*contact.normalY + velocityZ[contact.first]*contact.normalZ};
+    if(contact.secondMoves)
+        normalSpeed -= velocityX[contact.second]*contact.normalX + velocityY[contact.second]*contact.normalY + velocityZ[contact.second]*contact.normalZ;
+    float newImpulse{std::max(contact.normalImpulse - contact.effectiveMass*(normalSpeed - contact.velocityTarget), 0.0f)};
+    apply_impulse(contact, newImpulse - contact.normalImpulse, velocityX.data(), velocityY.data(), velocityZ.data());
+    contact.normalImpulse = newImpulse;
+}
+
+void ContactSolver::solve_position(Contact &contact)
+{
+    float normalSpeed{pseudoVelocityX[contact.first]*contact.normalX + pseudoVelocityY[contact.first]*contact.normalY + pseudoVelocityZ[contact.first]*contact.normalZ};
+    if(contact.secondMoves)
+        normalSpeed -= pseudoVelocityX[contact.second]*contact.normalX + pseudoVelocityY[contact.second]*contact.normalY + pseudoVelocityZ[contact.second]*contact.normalZ;
+    float newImpulse{std::max(contact.pseudoImpulse - contact.effectiveMass*(normalSpeed - contact.pseudoTarget), 0.0f)};
+    apply_impulse(contact, newImpulse - contact.pseudoImpulse, pseudoVelocityX.data(), pseudoVelocityY.data(), pseudoVelocityZ.data());
+    contact.pseudoImpulse = newImpulse;
+}
+
+// Kept sorted by key so the next step finds each contact by binary search.
+void ContactSolver::store_cache()
+{
+    nextCache.resize(coloredContacts.size());
+    for(unsigned int contactIndex{0}; contactIndex < coloredContacts.size(); contactIndex++)
+    {
+        const Contact &contact = coloredContacts[contactIndex];
+        nextCache[contactIndex] = CachedContact{contact.key, contact.generations, contact.normalImpulse, contact.bounceSpeed};
+    }
+    std::sort(nextCache.begin(), nextCache.end(), cached_contact_less);
+    cache.swap(nextCache);
+}
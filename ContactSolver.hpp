@@ -0,0 +1,124 @@
+#ifndef CONTACT_SOLVER_HPP
+#define CONTACT_SOLVER_HPP
+
+#include "BallStorage.hpp"
+#include "Broadphase.hpp"
+#include "ThreadPool.hpp"
+#include <cstdint>
+#include <vector>
+
+enum CollisionSolverType
+{
+    projectionSolver,
+    impulseSolver
+};
+
+struct CachedContact
+{
+    std::uint64_t key;
+    std::uint64_t generations;
+    float normalImpulse;
+    float bounceSpeed;
+};
+
+// One ball touching another ball, a sleeping ball or a wall. The normal
+// points from second to first. Sleeping balls and walls are static: their
+// inverse mass is zero and secondMoves is false.
+struct Contact
+{
+    std::uint64_t key;
+    std::uint64_t generations;
+    unsigned int first;
+    unsigned int second;
+    float normalX;
+    float normalY;
+    float normalZ;
+    float inverseMassFirst;
+    float inverseMassSecond;
+    float effectiveMass;
+    float velocityTarget;
+    float pseudoTarget;
+    float normalImpulse;
+    float pseudoImpulse;
+    float bounceSpeed;
+    bool secondMoves;
+};
+
+// Sequential-impulse contact solver. Contacts are keyed by the slots of the
+// balls touching, so the impulse a contact ended the last step with is
+// applied up front in the next one (warm starting) and a resting pile only
+// needs a few iterations to hold. The slots' generations are kept beside
+// the key, so a ball that takes over a recycled slot starts cold. A ball
+// closing a gap lands exactly on its contact, and the cache carries its
+// impact speed so it bounces with it on the next step. Overlap is removed
+// with split impulses: pseudo velocities that move the balls apart without
+// adding to their real velocity, so correcting position does not make
+// piles bounce.
+//
+// The solve runs after integration. Balls with contacts are moved again
+// from where they started the step with their solved velocity, which keeps
+// resting contacts exactly in place. Contacts are colored like the
+// projection solver's pairs, so any thread count gives the serial result.
+class ContactSolver
+{
+public:
+    void reserve(unsigned int capacity, unsigned int pairCapacity);
+    void solve(BallStorage &balls, const std::vector<BallPair> &pairs, const unsigned int *ballSlots, const unsigned int *slotGenerations, unsigned int ballCount, unsigned int awakeCount, float boxBoundSize, float deltaTime, ThreadPool &threadPool);
+    void clear_cache();
+    const std::vector<CachedContact>& get_cache();
+    void restore_cache(const std::vector<CachedContact> &savedCache);
+
+    unsigned int get_iterations();
+    unsigned int get_position_iterations();
+    float get_position_correction_factor();
+    float get_penetration_slop();
+    float get_restitution_threshold();
+    unsigned int get_contact_count();
+    unsigned int get_warm_started_count();
+
+    void set_iterations(unsigned int newIterations);
+    void set_position_iterations(unsigned int newIterations);
+    void set_position_correction_factor(float newFactor);
+    void set_penetration_slop(float newSlop);
+    void set_restitution_threshold(float newThreshold);
+
+protected:
+    void add_contact(const BallStorage &balls, unsigned int first, unsigned int second, std::uint64_t key, std::uint64_t generations, Eigen::Vector3f normal, float startSeparation, float separation, float coefficientOfRestitution, float deltaTime);
+    void add_ball_contacts(const BallStorage &balls, const std::vector<BallPair> &pairs, const unsigned int *ballSlots, const unsigned int *slotGenerations, float deltaTime);
+    void add_wall_contacts(const BallStorage &balls, const unsigned int *ballSlots, const unsigned int *slotGenerations, float boxBoundSize, float deltaTime);
+    void color_contacts();
+    template<typename Function>
+    void for_each_contact(ThreadPool &threadPool, const Function &function);
+    void apply_impulse(const Contact &contact, float impulse, float *velocityX, float *velocityY, float *velocityZ);
+    void solve_velocity(Contact &contact);
+    void solve_position(Contact &contact);
+    void store_cache();
+
+    unsigned int iterations{10};
+    unsigned int positionIterations{4};
+    float positionCorrectionFactor{0.2};
+    float penetrationSlop{0.005};
+    float restitutionThreshold{1};
+    float contactMargin{0.01};
+    unsigned int contactsPerTask{512};
+    unsigned int ballCount{0};
+    unsigned int awakeCount{0};
+    unsigned int warmStartedCount{0};
+
+    std::vector<Contact> contacts;
+    std::vector<Contact> coloredContacts;
+    std::vector<unsigned int> contactColors;
+    std::vector<unsigned int> colorStart;
+    std::vector<unsigned int> ballNextColor;
+    std::vector<CachedContact> cache;
+    std::vector<CachedContact> nextCache;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<float> velocityZ;
+    std::vector<float> pseudoVelocityX;
+    std::vector<float> pseudoVelocityY;
+    std::vector<float> pseudoVelocityZ;
+    std::vector<unsigned char> ballTouched;
+};
+
+#endif
@@ -0,0 +1,206 @@
+#include "gtest/gtest.h"
+#include "BallPhysics.hpp"
+#include <math.h>
+
+
+class ContactSolverTests : public ::testing::Test
+{
+protected:
+    void SetUp();
+    void add_ball(Eigen::Vector3f position, Eigen::Vector3f velocity);
+    void fill_pile(BallPhysics &pile, unsigned int ballCount);
+    float get_max_speed(BallPhysics &simulation);
+    float get_max_overlap(BallPhysics &simulation);
+    BallPhysics physics;
+    float radius{0.5};
+    float stepTime{1.0/30};
+};
+
+void ContactSolverTests::SetUp()
+{
+    physics.set_collision_solver_type(impulseSolver);
+    physics.set_sleeping_enabled(false);
+    physics.set_new_ball_radius(radius);
+}
+
+void ContactSolverTests::add_ball(Eigen::Vector3f position, Eigen::Vector3f velocity)
+{
+    physics.set_new_ball_position(position);
+    physics.set_new_ball_velocity(velocity);
+    physics.add_ball();
+}
+
+// Layers of balls touching each other, slightly jittered so they do not
+// stay perfectly stacked.
+void ContactSolverTests::fill_pile(BallPhysics &pile, unsigned int ballCount)
+{
+    unsigned int side{5};
+    float spacing{2*radius};
+    pile.set_max_ball_count(ballCount);
+    pile.set_box_size(side*radius);
+    pile.set_new_ball_radius(radius);
+    pile.set_new_ball_velocity(Eigen::Vector3f{0, 0, 0});
+    for(unsigned int ballIndex{0}; ballIndex < ballCount; ballIndex++)
+    {
+        float jitter{0.01f*(ballIndex%7)};
+        float x{(ballIndex%side - (side - 1)/2.0f)*spacing + jitter};
+        float y{((ballIndex/side)%side - (side - 1)/2.0f)*spacing - jitter};
+        float z{radius + ballIndex/(side*side)*spacing};
+        pile.set_new_ball_position(Eigen::Vector3f{x, y, z});
+        pile.add_ball();
+    }
+}
+
+float ContactSolverTests::get_max_speed(BallPhysics &simulation)
+{
+    float maxSpeed{0};
+    for(unsigned int ballIndex{0}; ballIndex < simulation.get_ball_count(); ballIndex++)
+        maxSpeed = fmax(maxSpeed, Eigen::Vector3f{simulation.get_ball_ptr(ballIndex)->velocity}.norm());
+    return maxSpeed;
+}
+
+float ContactSolverTests::get_max_overlap(BallPhysics &simulation)
+{
+    float maxOverlap{0};
+    for(unsigned int first{0}; first < simulation.get_ball_count(); first++)
+    {
+        for(unsigned int second{first + 1}; second < simulation.get_ball_count(); second++)
+        {
+            Eigen::Vector3f firstPosition{simulation.get_ball_ptr(first)->position};
+            Eigen::Vector3f secondPosition{simulation.get_ball_ptr(second)->position};
+            float contactDistance{simulation.get_ball_ptr(first)->radius + simulation.get_ball_ptr(second)->radius};
+            maxOverlap = fmax(maxOverlap, contactDistance - (firstPosition - secondPosition).norm());
+        }
+    }
+    return maxOverlap;
+}
+
+TEST_F(ContactSolverTests, WhenBallRestsOnFloor_ExpectItStaysInPlace)
+{
+    add_ball(Eigen::Vector3f{0, 0, radius}, Eigen::Vector3f{0, 0, 0});
+
+    for(int step{0}; step < 60; step++)
+        physics.update(stepTime);
+
+    EXPECT_NEAR(physics.get_ball_ptr(0)->position[2], radius, 1e-5);
+    EXPECT_NEAR(physics.get_ball_ptr(0)->velocity[2], 0, 1e-5);
+}
+
+TEST_F(ContactSolverTests, WhenBallFallsFast_ExpectItBouncesWithoutPassingFloor)
+{
+    add_ball(Eigen::Vector3f{0, 0, 3}, Eigen::Vector3f{0, 0, -30});
+
+    float lowestHeight{3};
+    float highestUpwardSpeed{0};
+    for(int step{0}; step < 10; step++)
+    {
+        physics.update(stepTime);
+        lowestHeight = fmin(lowestHeight, physics.get_ball_ptr(0)->position[2]);
+        highestUpwardSpeed = fmax(highestUpwardSpeed, physics.get_ball_ptr(0)->velocity[2]);
+    }
+
+    EXPECT_GE(lowestHeight, radius - 1e-4);
+    EXPECT_GT(highestUpwardSpeed, 0.6*30);
+}
+
+TEST_F(ContactSolverTests, WhenStackingColumnAt30Hz_ExpectColumnStaysStacked)
+{
+    float slop{physics.get_contact_solver_ptr()->get_penetration_slop()};
+    for(int ballIndex{0}; ballIndex < 10; ballIndex++)
+        add_ball(Eigen::Vector3f{0, 0, radius*(1 + 2*ballIndex)}, Eigen::Vector3f{0, 0, 0});
+
+    for(int step{0}; step < 300; step++)
+        physics.update(stepTime);
+
+    for(unsigned int ballIndex{0}; ballIndex < 10; ballIndex++)
+    {
+        EXPECT_NEAR(physics.get_ball_ptr(ballIndex)->position[0], 0, 1e-4);
+        EXPECT_NEAR(physics.get_ball_ptr(ballIndex)->position[2], radius*(1 + 2*ballIndex), 10*slop);
+    }
+    EXPECT_LT(get_max_overlap(physics), 2*slop);
+    EXPECT_LT(get_max_speed(physics), 0.01);
+}
+
+TEST_F(ContactSolverTests, WhenPileSettlesAt30Hz_ExpectItComesToRestWithSmallOverlap)
+{
+    fill_pile(physics, 150);
+
+    for(int step{0}; step < 300; step++)
+        physics.update(stepTime);
+
+    EXPECT_LT(get_max_speed(physics), 0.05);
+    EXPECT_LT(get_max_overlap(physics), 0.05*radius);
+    for(unsigned int ballIndex{0}; ballIndex < physics.get_ball_count(); ballIndex++)
+        EXPECT_GE(physics.get_ball_ptr(ballIndex)->position[2], radius - 0.05*radius);
+}
+
+TEST_F(ContactSolverTests, WhenContactsPersist_ExpectThemWarmStarted)
+{
+    add_ball(Eigen::Vector3f{0, 0, radius}, Eigen::Vector3f{0, 0, 0});
+    add_ball(Eigen::Vector3f{0, 0, 3*radius}, Eigen::Vector3f{0, 0, 0});
+
+    physics.update(stepTime);
+    EXPECT_EQ(physics.get_contact_solver_ptr()->get_warm_started_count(), 0);
+    physics.update(stepTime);
+
+    EXPECT_EQ(physics.get_contact_solver_ptr()->get_contact_count(), 2);
+    EXPECT_EQ(physics.get_contact_solver_ptr()->get_warm_started_count(), 2);
+}
+
+TEST_F(ContactSolverTests, WhenSolvingWithThreads_ExpectSameResultAsSerial)
+{
+    BallPhysics serial;
+    BallPhysics threaded;
+    threaded.set_thread_count(4);
+    for(BallPhysics *pile : {&serial, &threaded})
+    {
+        pile->set_collision_solver_type(impulseSolver);
+        fill_pile(*pile, 1000);
+        pile->get_contact_solver_ptr()->set_iterations(6);
+        for(int step{0}; step < 20; step++)
+            pile->update(stepTime);
+    }
+
+    for(unsigned int ballIndex{0}; ballIndex < serial.get_ball_count(); ballIndex++)
+        EXPECT_EQ(Eigen::Vector3f{serial.get_ball_ptr(ballIndex)->position}, Eigen::Vector3f{threaded.get_ball_ptr(ballIndex)->position});
+}
+
+TEST_F(ContactSolverTests, WhenRestoringState_ExpectCacheRestoredAndIdenticalSteps)
+{
+    fill_pile(physics, 100);
+    for(int step{0}; step < 10; step++)
+        physics.update(stepTime);
+    BallPhysicsState state;
+    physics.save_state(state);
+    for(int step{0}; step < 10; step++)
+        physics.update(stepTime);
+    std::vector<Eigen::Vector3f> expectedPositions;
+    for(unsigned int ballIndex{0}; ballIndex < physics.get_ball_count(); ballIndex++)
+        expectedPositions.push_back(physics.get_ball_ptr(ballIndex)->position);
+
+    physics.restore_state(state);
+    for(int step{0}; step < 10; step++)
+        physics.update(stepTime);
+
+    EXPECT_FALSE(state.contactCache.empty());
+    for(unsigned int ballIndex{0}; ballIndex < physics.get_ball_count(); ballIndex++)
+        EXPECT_EQ(Eigen::Vector3f{physics.get_ball_ptr(ballIndex)->position}, expectedPositions[ballIndex]);
+}
+
+TEST_F(ContactSolverTests, WhenSlotIsRecycled_ExpectNewBallNotWarmStarted)
+{
+    add_ball(Eigen::Vector3f{0, 0, radius}, Eigen::Vector3f{0, 0, 0});
+    for(int step{0}; step < 5; step++)
+        physics.update(stepTime);
+    ASSERT_EQ(physics.get_contact_solver_ptr()->get_warm_started_count(), 1);
+    BallHandle restingBall{physics.get_ball_handle(0)};
+
+    ASSERT_TRUE(physics.remove_ball(restingBall));
+    physics.set_new_ball_position(Eigen::Vector3f{0, 0, radius});
+    BallHandle newBall{physics.add_ball()};
+    physics.update(stepTime);
+
+    EXPECT_EQ(newBall.slot, restingBall.slot);
+    EXPECT_EQ(physics.get_contact_solver_ptr()->get_contact_count(), 1);
+    EXPECT_EQ(physics.get_contact_solver_ptr()->get_warm_started_count(), 0);
+}
@@ -0,0 +1,197 @@
+#include "ContinuousCollision.hpp"
+#include <algorithm>
+#include <math.h>
+
+
+namespace
+{
+bool swept_ball_less(const SweptBall &first, const SweptBall &second)
+{
+    return first.lowerX < second.lowerX || (first.lowerX == second.lowerX && first.fastIndex < second.fastIndex);
+}
+}
+
+namespace sweptsphere
+{
+// The fraction of the step at which two spheres starting startOffset apart
+// first come within contactDistance, or 1 if they do not. Spheres that
+// already touch at the start are left to the regular response.
+float get_sphere_impact_time(Eigen::Vector3f startOffset, Eigen::Vector3f relativeMotion, float contactDistance)
+{
+    float startGap{startOffset.squaredNorm() - contactDistance*contactDistance};
+    float approach{startOffset.dot(relativeMotion)};
+    if(startGap <= 0 || approach >= 0)
+        return 1;
+    float discriminant{approach*approach - relativeMotion.squaredNorm()*startGap};
+    if(discriminant < 0)
+        return 1;
+    float impactTime{startGap/(-approach + sqrtf(discriminant))};
+    return std::min(impactTime, 1.0f);
+}
+
+// The fraction of the step at which a coordinate moving from start to end
+// drops below limit, or 1 if it does not.
+float get_plane_impact_time(float start, float end, float limit)
+{
+    if(start < limit || end >= limit)
+        return 1;
+    return (start - limit)/(start - end);
+}
+}
+
+void ContinuousCollision::reserve(unsigned int capacity)
+{
+    grid.reserve(capacity);
+    fastBalls.reserve(capacity);
+    ballFast.reserve(capacity);
+    sweptBalls.reserve(capacity);
+    impactTimes.reserve(capacity);
+    candidates.reserve(capacity);
+}
+
+// Only meant for awake balls. It reads nothing sweep() keeps, so it gives the
+// same answer during integration as in the sweep that follows.
+bool ContinuousCollision::is_fast(const BallStorage &balls, unsigned int index)
+{
+    float threshold{motionFraction*balls.radius[index]};
+    return get_step_motion(balls, index).squaredNorm() > threshold*threshold;
+}
+
+// Slow balls are found through a grid of where they ended the step, searched
+// far enough around each fast ball's path to cover their own short motion.
+// Fast balls can end anywhere, so they are checked against each other by
+// sweeping their paths along x. Every impact time is found before any ball
+// is moved, which keeps the result independent of order.
+void ContinuousCollision::sweep(BallStorage &balls, unsigned int ballCount, unsigned int awakeCount, float boxBoundSize)
+{
+    fastBalls.clear();
+    impactCount = 0;
+    this->awakeCount = awakeCount;
+    for(unsigned int ballIndex{0}; ballIndex < awakeCount; ballIndex++)
+    {
+        if(is_fast(balls, ballIndex))
+            fastBalls.push_back(ballIndex);
+    }
+    if(fastBalls.empty())
+        return;
+
+    ballFast.assign(ballCount, 0);
+    for(unsigned int ballIndex : fastBalls)
+        ballFast[ballIndex] = 1;
+    grid.build(balls, ballCount, boxBoundSize);
+    float maxRadius{grid.get_cell_size()/2};
+
+    impactTimes.assign(fastBalls.size(), 1);
+    sweptBalls.resize(fastBalls.size());
+    for(unsigned int fastIndex{0}; fastIndex < fastBalls.size(); fastIndex++)
+    {
+        unsigned int ballIndex{fastBalls[fastIndex]};
+        Eigen::Vector3f start{get_start_position(balls, ballIndex)};
+        Eigen::Vector3f end{balls.get_position(ballIndex)};
+        float reach{balls.radius[ballIndex] + maxRadius*(1 + motionFraction)};
+        Eigen::Vector3f lower{start.cwiseMin(end) - Eigen::Vector3f::Constant(reach)};
+        Eigen::Vector3f upper{start.cwiseMax(end) + Eigen::Vector3f::Constant(reach)};
+
+        float impactTime{find_wall_impact(balls, ballIndex, boxBoundSize)};
+        grid.find_in_bounds(lower, upper, candidates);
+        for(unsigned int candidateIndex : candidates)
+        {
+            if(!ballFast[candidateIndex])
+                impactTime = std::min(impactTime, find_ball_impact(balls, ballIndex, candidateIndex));
+        }
+        impactTimes[fastIndex] = impactTime;
+        sweptBalls[fastIndex] = SweptBall{std::min(start[0], end[0]) - balls.radius[ballIndex], std::max(start[0], end[0]) + balls.radius[ballIndex], fastIndex};
+    }
+
+    std::sort(sweptBalls.begin(), sweptBalls.end(), swept_ball_less);
+    for(unsigned int sweptIndex{0}; sweptIndex < sweptBalls.size(); sweptIndex++)
+    {
+        const SweptBall &swept = sweptBalls[sweptIndex];
+        for(unsigned int otherIndex{sweptIndex + 1}; otherIndex < sweptBalls.size() && sweptBalls[otherIndex].lowerX <= swept.upperX; otherIndex++)
+        {
+            const SweptBall &other = sweptBalls[otherIndex];
+            float impactTime{find_ball_impact(balls, fastBalls[swept.fastIndex], fastBalls[other.fastIndex])};
+            impactTimes[swept.fastIndex] = std::min(impactTimes[swept.fastIndex], impactTime);
+            impactTimes[other.fastIndex] = std::min(impactTimes[other.fastIndex], impactTime);
+        }
+    }
+
+    for(unsigned int fastIndex{0}; fastIndex < fastBalls.size(); fastIndex++)
+    {
+        if(impactTimes[fastIndex] >= 1)
+            continue;
+        unsigned int ballIndex{fastBalls[fastIndex]};
+        Eigen::Vector3f start{get_start_position(balls, ballIndex)};
+        balls.set_position(ballIndex, start + impactTimes[fastIndex]*get_motion(balls, ballIndex));
+        impactCount++;
+    }
+}
+
+float ContinuousCollision::get_motion_fraction()
+{
+    return this->motionFraction;
+}
+
+unsigned int ContinuousCollision::get_swept_ball_count()
+{
+    return fastBalls.size();
+}
+
+const std::vector<unsigned int>& ContinuousCollision::get_swept_balls()
+{
+    return this->fastBalls;
+}
+
+unsigned int ContinuousCollision::get_impact_count()
+{
+    return this->impactCount;
+}
+
+void ContinuousCollision::set_motion_fraction(float newFraction)
+{
+    this->motionFraction = newFraction;
+}
+
+float ContinuousCollision::find_ball_impact(const BallStorage &balls, unsigned int first, unsigned int second)
+{
+    Eigen::Vector3f startOffset{get_start_position(balls, first) - get_start_position(balls, second)};
+    Eigen::Vector3f relativeMotion{get_motion(balls, first) - get_motion(balls, second)};
+    float contactDistance{(balls.radius[first] + balls.radius[second])*(1 - contactSkin)};
+    return sweptsphere::get_sphere_impact_time(startOffset, relativeMotion, contactDistance);
+}
+
+// The walls are planes at plus and minus boxBoundSize in x and y, the floor
+// is z = 0. Upper walls are mirrored so they become lower limits too.
+float ContinuousCollision::find_wall_impact(const BallStorage &balls, unsigned int index, float boxBoundSize)
+{
+    Eigen::Vector3f start{get_start_position(balls, index)};
+    Eigen::Vector3f end{balls.get_position(index)};
+    float limit{balls.radius[index]*(1 - contactSkin)};
+    float impactTime{sweptsphere::get_plane_impact_time(start[2], end[2], limit)};
+    for(int axis{0}; axis < 2; axis++)
+    {
+        impactTime = std::min(impactTime, sweptsphere::get_plane_impact_time(start[axis], end[axis], limit - boxBoundSize));
+        impactTime = std::min(impactTime, sweptsphere::get_plane_impact_time(-start[axis], -end[axis], limit - boxBoundSize));
+    }
+    return impactTime;
+}
+
+// Sleeping balls have not moved, whatever their previous position says.
+Eigen::Vector3f ContinuousCollision::get_motion(const BallStorage &balls, unsigned int index)
+{
+    if(index >= awakeCount)
+        return Eigen::Vector3f::Zero();
+    return get_step_motion(balls, index);
+}
+
+Eigen::Vector3f ContinuousCollision::get_step_motion(const BallStorage &balls, unsigned int index)
+{
+    return Eigen::Vector3f{balls.positionX[index] - balls.previousPositionX[index],
+                           balls.positionY[index] - balls.previousPositionY[index],
+                           balls.positionZ[index] - balls.previousPositionZ[index]};
+}
+
+Eigen::Vector3f ContinuousCollision::get_start_position(const BallStorage &balls, unsigned int index)
+{
+    return balls.get_position(index) - get_motion(balls, index);
+}
@@ -0,0 +1,60 @@
+#ifndef CONTINUOUS_COLLISION_HPP
+#define CONTINUOUS_COLLISION_HPP
+
+#include "BallStorage.hpp"
+#include "SpatialHashGrid.hpp"
+#include <vector>
+
+namespace sweptsphere
+{
+    float get_sphere_impact_time(Eigen::Vector3f startOffset, Eigen::Vector3f relativeMotion, float contactDistance);
+    float get_plane_impact_time(float start, float end, float limit);
+}
+
+struct SweptBall
+{
+    float lowerX;
+    float upperX;
+    unsigned int fastIndex;
+};
+
+// Swept-sphere continuous collision for balls that moved more than
+// motionFraction of their radius this step. Each such ball is moved back
+// along its step to the first time it reaches another ball, the floor or
+// a wall, every ball being taken to move in a straight line from its
+// previous position. It stops just inside the contact so the collision
+// response of the step sees the hit; the rest of its motion is dropped.
+// Balls that move less are never looked at beyond one distance check.
+class ContinuousCollision
+{
+public:
+    void reserve(unsigned int capacity);
+    bool is_fast(const BallStorage &balls, unsigned int index);
+    void sweep(BallStorage &balls, unsigned int ballCount, unsigned int awakeCount, float boxBoundSize);
+
+    float get_motion_fraction();
+    unsigned int get_swept_ball_count();
+    const std::vector<unsigned int>& get_swept_balls();
+    unsigned int get_impact_count();
+    void set_motion_fraction(float newFraction);
+
+protected:
+    float find_ball_impact(const BallStorage &balls, unsigned int first, unsigned int second);
+    float find_wall_impact(const BallStorage &balls, unsigned int index, float boxBoundSize);
+    Eigen::Vector3f get_motion(const BallStorage &balls, unsigned int index);
+    Eigen::Vector3f get_step_motion(const BallStorage &balls, unsigned int index);
+    Eigen::Vector3f get_start_position(const BallStorage &balls, unsigned int index);
+
+    float motionFraction{0.5};
+    float contactSkin{0.01};
+    unsigned int awakeCount{0};
+    unsigned int impactCount{0};
+    SpatialHashGrid grid;
+    std::vector<unsigned int> fastBalls;
+    std::vector<unsigned char> ballFast;
+    std::vector<SweptBall> sweptBalls;
+    std::vector<float> impactTimes;
+    std::vector<unsigned int> candidates;
+};
+
+#endif
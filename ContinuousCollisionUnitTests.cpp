@@ -0,0 +1,224 @@
+#include "gtest/gtest.h"
+#include "ContinuousCollision.hpp"
+#include "BallPhysics.hpp"
+
+
+class ContinuousCollisionTests : public ::testing::Test
+{
+protected:
+    void add_ball(Eigen::Vector3f previousPosition, Eigen::Vector3f position);
+    void shoot_through_ball(BallPhysics &simulation);
+    ContinuousCollision continuousCollision;
+    BallStorage balls;
+    float radius{0.5};
+    float boxSize{10};
+    float stepTime{1.0/30};
+};
+
+void ContinuousCollisionTests::add_ball(Eigen::Vector3f previousPosition, Eigen::Vector3f position)
+{
+    Ball ball;
+    ball.radius = radius;
+    ball.position = position;
+    balls.push_back(ball);
+    balls.previousPositionX.back() = previousPosition[0];
+    balls.previousPositionY.back() = previousPosition[1];
+    balls.previousPositionZ.back() = previousPosition[2];
+}
+
+// One step carries the first ball from well before the second to well past
+// it, so without a swept test the two never overlap.
+void ContinuousCollisionTests::shoot_through_ball(BallPhysics &simulation)
+{
+    simulation.set_gravity(0);
+    simulation.set_box_size(boxSize);
+    simulation.set_sleeping_enabled(false);
+    simulation.set_new_ball_radius(radius);
+    simulation.set_new_ball_position(Eigen::Vector3f{-2.5, 0, 3});
+    simulation.set_new_ball_velocity(Eigen::Vector3f{150, 0, 0});
+    simulation.add_ball();
+    simulation.set_new_ball_position(Eigen::Vector3f{0, 0, 3});
+    simulation.set_new_ball_velocity(Eigen::Vector3f{0, 0, 0});
+    simulation.add_ball();
+    simulation.update(stepTime);
+}
+
+TEST_F(ContinuousCollisionTests, WhenSpheresApproach_ExpectImpactTimeAtContactDistance)
+{
+    float impactTime{sweptsphere::get_sphere_impact_time(Eigen::Vector3f{10, 0, 0}, Eigen::Vector3f{-20, 0, 0}, 2)};
+
+    EXPECT_NEAR(impactTime, 0.4, 1e-6);
+}
+
+TEST_F(ContinuousCollisionTests, WhenSpheresMissOrSeparate_ExpectNoImpact)
+{
+    EXPECT_EQ(sweptsphere::get_sphere_impact_time(Eigen::Vector3f{10, 3, 0}, Eigen::Vector3f{-20, 0, 0}, 2), 1);
+    EXPECT_EQ(sweptsphere::get_sphere_impact_time(Eigen::Vector3f{10, 0, 0}, Eigen::Vector3f{20, 0, 0}, 2), 1);
+    EXPECT_EQ(sweptsphere::get_sphere_impact_time(Eigen::Vector3f{10, 0, 0}, Eigen::Vector3f{-5, 0, 0}, 2), 1);
+    EXPECT_EQ(sweptsphere::get_sphere_impact_time(Eigen::Vector3f{1, 0, 0}, Eigen::Vector3f{-5, 0, 0}, 2), 1);
+}
+
+TEST_F(ContinuousCollisionTests, WhenCoordinateCrossesLimit_ExpectPlaneImpactTime)
+{
+    EXPECT_NEAR(sweptsphere::get_plane_impact_time(5, -5, 0.5), 0.45, 1e-6);
+    EXPECT_EQ(sweptsphere::get_plane_impact_time(5, 1, 0.5), 1);
+    EXPECT_EQ(sweptsphere::get_plane_impact_time(0.2, -5, 0.5), 1);
+}
+
+TEST_F(ContinuousCollisionTests, WhenBallsMoveLessThanFraction_ExpectNothingSwept)
+{
+    add_ball(Eigen::Vector3f{0, 0, 3}, Eigen::Vector3f{0.2, 0, 3});
+    add_ball(Eigen::Vector3f{2, 0, 3}, Eigen::Vector3f{2, 0, 2.9});
+
+    continuousCollision.sweep(balls, 2, 2, boxSize);
+
+    EXPECT_EQ(continuousCollision.get_swept_ball_count(), 0);
+    EXPECT_EQ(continuousCollision.get_impact_count(), 0);
+    EXPECT_FLOAT_EQ(balls.positionX[0], 0.2);
+}
+
+TEST_F(ContinuousCollisionTests, WhenFastBallPassesThroughBall_ExpectItStopsAtContact)
+{
+    add_ball(Eigen::Vector3f{-5, 0, 3}, Eigen::Vector3f{5, 0, 3});
+    add_ball(Eigen::Vector3f{0, 0, 3}, Eigen::Vector3f{0, 0, 3});
+
+    continuousCollision.sweep(balls, 2, 2, boxSize);
+
+    EXPECT_EQ(continuousCollision.get_swept_ball_count(), 1);
+    EXPECT_EQ(continuousCollision.get_impact_count(), 1);
+    EXPECT_LT(balls.positionX[0], -2*radius*0.98);
+    EXPECT_GT(balls.positionX[0], -2*radius);
+    EXPECT_FLOAT_EQ(balls.positionX[1], 0);
+}
+
+TEST_F(ContinuousCollisionTests, WhenFastBallsCross_ExpectBothStopAtContact)
+{
+    add_ball(Eigen::Vector3f{-5, 0, 3}, Eigen::Vector3f{5, 0, 3});
+    add_ball(Eigen::Vector3f{5, 0, 3}, Eigen::Vector3f{-5, 0, 3});
+
+    continuousCollision.sweep(balls, 2, 2, boxSize);
+
+    EXPECT_EQ(continuousCollision.get_impact_count(), 2);
+    EXPECT_NEAR(balls.positionX[0], -radius, 0.02*radius);
+    EXPECT_NEAR(balls.positionX[1], radius, 0.02*radius);
+}
+
+TEST_F(ContinuousCollisionTests, WhenFastBallPassesSleepingBall_ExpectItStopsAtSleepingBall)
+{
+    add_ball(Eigen::Vector3f{-5, 0, 3}, Eigen::Vector3f{5, 0, 3});
+    add_ball(Eigen::Vector3f{-20, 0, 3}, Eigen::Vector3f{0, 0, 3});
+
+    continuousCollision.sweep(balls, 2, 1, boxSize);
+
+    EXPECT_EQ(continuousCollision.get_swept_ball_count(), 1);
+    EXPECT_LT(balls.positionX[0], -2*radius*0.98);
+}
+
+TEST_F(ContinuousCollisionTests, WhenFastBallLeavesBox_ExpectItStopsAtFloorOrWall)
+{
+    add_ball(Eigen::Vector3f{0, 0, 5}, Eigen::Vector3f{0, 0, -5});
+    add_ball(Eigen::Vector3f{5, 3, 3}, Eigen::Vector3f{15, 3, 3});
+    add_ball(Eigen::Vector3f{3, -5, 3}, Eigen::Vector3f{3, -15, 3});
+
+    continuousCollision.sweep(balls, 3, 3, boxSize);
+
+    EXPECT_EQ(continuousCollision.get_impact_count(), 3);
+    EXPECT_NEAR(balls.positionZ[0], radius, 0.02*radius);
+    EXPECT_NEAR(balls.positionX[1], boxSize - radius, 0.02*radius);
+    EXPECT_NEAR(balls.positionY[2], radius - boxSize, 0.02*radius);
+}
+
+TEST_F(ContinuousCollisionTests, WhenFastBallShotThroughBallWithoutSweep_ExpectItTunnels)
+{
+    BallPhysics physics;
+    shoot_through_ball(physics);
+
+    EXPECT_GT(physics.get_ball_ptr(0)->position[0], 2*radius);
+    EXPECT_EQ(physics.get_ball_ptr(1)->velocity[0], 0);
+}
+
+TEST_F(ContinuousCollisionTests, WhenFastBallShotThroughBallWithSweep_ExpectCollision)
+{
+    for(CollisionSolverType solverType : {projectionSolver, impulseSolver})
+    {
+        BallPhysics physics;
+        physics.set_collision_solver_type(solverType);
+        physics.set_continuous_collision_enabled(true);
+        shoot_through_ball(physics);
+
+        EXPECT_LT(physics.get_ball_ptr(0)->position[0], physics.get_ball_ptr(1)->position[0]);
+        EXPECT_LT(physics.get_ball_ptr(0)->velocity[0], 150);
+        EXPECT_GT(physics.get_ball_ptr(1)->velocity[0], 0);
+    }
+}
+
+TEST_F(ContinuousCollisionTests, WhenFastBallFallsWithSweep_ExpectItBouncesOffFloor)
+{
+    for(CollisionSolverType solverType : {projectionSolver, impulseSolver})
+    {
+        BallPhysics physics;
+        physics.set_collision_solver_type(solverType);
+        physics.set_continuous_collision_enabled(true);
+        physics.set_new_ball_radius(radius);
+        physics.set_new_ball_position(Eigen::Vector3f{0, 0, 3});
+        physics.set_new_ball_velocity(Eigen::Vector3f{0, 0, -120});
+        physics.add_ball();
+
+        float lowestHeight{3};
+        float highestUpwardSpeed{0};
+        for(int step{0}; step < 5; step++)
+        {
+            physics.update(stepTime);
+            lowestHeight = fmin(lowestHeight, physics.get_ball_ptr(0)->position[2]);
+            highestUpwardSpeed = fmax(highestUpwardSpeed, physics.get_ball_ptr(0)->velocity[2]);
+        }
+
+        EXPECT_GE(lowestHeight, radius - 0.01*radius);
+        EXPECT_GT(highestUpwardSpeed, 0.5*120);
+    }
+}
+
+TEST_F(ContinuousCollisionTests, WhenFreshlySpawnedBallIsFast_ExpectItSweptOnFirstStep)
+{
+    BallPhysics physics;
+    physics.set_box_size(boxSize);
+    physics.set_continuous_collision_enabled(true);
+    physics.set_new_ball_radius(radius);
+    physics.set_new_ball_position(Eigen::Vector3f{9, 0, 3});
+    physics.set_new_ball_velocity(Eigen::Vector3f{60, 0, 0});
+    physics.add_ball();
+
+    physics.update(stepTime);
+
+    EXPECT_EQ(physics.get_continuous_collision_ptr()->get_swept_ball_count(), 1);
+    EXPECT_EQ(physics.get_continuous_collision_ptr()->get_impact_count(), 1);
+    EXPECT_NEAR(physics.get_ball_ptr(0)->position[0], boxSize - radius, 0.02*radius);
+}
+
+TEST_F(ContinuousCollisionTests, WhenReplayingFromSavedState_ExpectSameSteps)
+{
+    BallPhysics physics;
+    physics.set_continuous_collision_enabled(true);
+    Emitter nozzle(Eigen::Vector3f{0, 0, 0.5}, Eigen::Vector3f{0, 0, 1}, 40, 200);
+    nozzle.set_spread_angle(0.6);
+    physics.add_emitter(nozzle);
+    for(int step{0}; step < 30; step++)
+        physics.update(stepTime);
+    BallPhysicsState state;
+    physics.save_state(state);
+    for(int step{0}; step < 30; step++)
+        physics.update(stepTime);
+    std::vector<Eigen::Vector3f> expectedPositions;
+    for(unsigned int ballIndex{0}; ballIndex < physics.get_ball_count(); ballIndex++)
+        expectedPositions.push_back(physics.get_ball_ptr(ballIndex)->position);
+
+    BallPhysics replay;
+    replay.set_continuous_collision_enabled(true);
+    replay.restore_state(state);
+    for(int step{0}; step < 30; step++)
+        replay.update(stepTime);
+
+    ASSERT_EQ(replay.get_ball_count(), expectedPositions.size());
+    for(unsigned int ballIndex{0}; ballIndex < replay.get_ball_count(); ballIndex++)
+        EXPECT_EQ(Eigen::Vector3f{replay.get_ball_ptr(ballIndex)->position}, expectedPositions[ballIndex]);
+}
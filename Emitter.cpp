@@ -0,0 +1,211 @@
+#include "Emitter.hpp"
+#include <algorithm>
+#include <math.h>
+#include <sstream>
+
+
+Emitter::Emitter(Eigen::Vector3f positionInput, Eigen::Vector3f directionInput, float speedInput, float ballsPerSecondInput, unsigned int seedInput): position{positionInput}, speed{speedInput}, ballsPerSecond{ballsPerSecondInput}, generator{seedInput}
+{
+    set_direction(directionInput);
+}
+
+unsigned int Emitter::advance(float deltaTime)
+{
+    if(ballsPerSecond <= 0)
+        return 0;
+    emissionAccumulator += ballsPerSecond*deltaTime;
+    unsigned int count(emissionAccumulator);
+    emissionAccumulator -= count;
+    return count;
+}
+
+// Time since ball spawnIndex of the last advance() left the nozzle, with the
+// newest ball emitted the accumulator's leftover fraction of a period ago.
+float Emitter::get_spawn_age(unsigned int spawnIndex, unsigned int count)
+{
+    return (emissionAccumulator + (count - 1 - spawnIndex))/ballsPerSecond;
+}
+
+Ball Emitter::sample_ball()
+{
+    float cosine{sample_uniform(cos(spreadAngle), 1)};
+    float sine{float(sqrt(fmax(0, 1 - cosine*cosine)))};
+    float azimuth{sample_uniform(0, 2*M_PI)};
+    Eigen::Vector3f tangent{fabs(direction[0]) < 0.9 ? Eigen::Vector3f{1.0, 0.0, 0.0} : Eigen::Vector3f{0.0, 1.0, 0.0}};
+    Eigen::Vector3f firstAxis{direction.cross(tangent).normalized()};
+    Eigen::Vector3f secondAxis{direction.cross(firstAxis)};
+    Eigen::Vector3f launchDirection{cosine*direction + sine*(float(cos(azimuth))*firstAxis + float(sin(azimuth))*secondAxis)};
+
+    unsigned int color(sample_uniform(minColor, maxColor + 1));
+    Ball newBall(sample_uniform(minRadius, maxRadius), sample_uniform(minMass, maxMass), std::min(color, maxColor), position, speed*launchDirection, Eigen::Vector3f{0.0, 0.0, 0.0}, sample_uniform(minCoefficientOfRestitution, maxCoefficientOfRestitution));
+    return newBall;
+}
+
+float Emitter::sample_uniform(float minValue, float maxValue)
+{
+    if(maxValue <= minValue)
+        return minValue;
+    return std::uniform_real_distribution<float>(minValue, maxValue)(generator);
+}
+
+Eigen::Vector3f Emitter::get_position()
+{
+    return this->position;
+}
+
+Eigen::Vector3f Emitter::get_direction()
+{
+    return this->direction;
+}
+
+float Emitter::get_speed()
+{
+    return this->speed;
+}
+
+float Emitter::get_spread_angle()
+{
+    return this->spreadAngle;
+}
+
+float Emitter::get_balls_per_second()
+{
+    return this->ballsPerSecond;
+}
+
+float Emitter::get_min_radius()
+{
+    return this->minRadius;
+}
+
+float Emitter::get_max_radius()
+{
+    return this->maxRadius;
+}
+
+float Emitter::get_min_mass()
+{
+    return this->minMass;
+}
+
+float Emitter::get_max_mass()
+{
+    return this->maxMass;
+}
+
+unsigned int Emitter::get_min_color()
+{
+    return this->minColor;
+}
+
+unsigned int Emitter::get_max_color()
+{
+    return this->maxColor;
+}
+
+float Emitter::get_min_coefficient_of_restitution()
+{
+    return this->minCoefficientOfRestitution;
+}
+
+float Emitter::get_max_coefficient_of_restitution()
+{
+    return this->maxCoefficientOfRestitution;
+}
+
+double Emitter::get_emission_accumulator()
+{
+    return this->emissionAccumulator;
+}
+
+// The generator only exposes its state through its text form: the state
+// words, followed by the index on standard libraries that write one. The
+// index defaults to state_size, where a fresh block starts.
+GeneratorState Emitter::get_generator_state()
+{
+    std::stringstream text;
+    text << generator;
+    GeneratorState state;
+    for(std::uint32_t &word : state.words)
+        text >> word;
+    if(!(text >> state.index))
+        state.index = std::mt19937::state_size;
+    return state;
+}
+
+void Emitter::set_position(Eigen::Vector3f newPosition)
+{
+    this->position = newPosition;
+}
+
+void Emitter::set_direction(Eigen::Vector3f newDirection)
+{
+    if(newDirection.norm() > 0)
+        this->direction = newDirection.normalized();
+}
+
+void Emitter::set_speed(float newSpeed)
+{
+    this->speed = newSpeed;
+}
+
+void Emitter::set_spread_angle(float newAngle)
+{
+    this->spreadAngle = newAngle;
+}
+
+void Emitter::set_balls_per_second(float newRate)
+{
+    this->ballsPerSecond = newRate;
+}
+
+void Emitter::set_radius_range(float newMinRadius, float newMaxRadius)
+{
+    this->minRadius = newMinRadius;
+    this->maxRadius = newMaxRadius;
+}
+
+void Emitter::set_mass_range(float newMinMass, float newMaxMass)
+{
+    this->minMass = newMinMass;
+    this->maxMass = newMaxMass;
+}
+
+void Emitter::set_color_range(unsigned int newMinColor, unsigned int newMaxColor)
+{
+    this->minColor = newMinColor;
+    this->maxColor = newMaxColor;
+}
+
+void Emitter::set_coefficient_of_restitution_range(float newMinCoefficient, float newMaxCoefficient)
+{
+    this->minCoefficientOfRestitution = newMinCoefficient;
+    this->maxCoefficientOfRestitution = newMaxCoefficient;
+}
+
+void Emitter::set_emission_accumulator(double newAccumulator)
+{
+    this->emissionAccumulator = newAccumulator;
+}
+
+// Rejects an index past the state and the all-zero state, which a zeroed
+// or cut-off record would give and from which the generator never recovers.
+bool Emitter::set_generator_state(const GeneratorState &newState)
+{
+    bool anyBitSet{false};
+    for(std::uint32_t word : newState.words)
+        anyBitSet = anyBitSet || word != 0;
+    if(!anyBitSet || newState.index > std::mt19937::state_size)
+        return false;
+
+    std::stringstream text;
+    for(std::uint32_t word : newState.words)
+        text << word << ' ';
+    text << newState.index;
+    std::mt19937 newGenerator;
+    text >> newGenerator;
+    if(text.fail())
+        return false;
+    this->generator = newGenerator;
+    return true;
+}
@@ -0,0 +1,75 @@
+#ifndef EMITTER_HPP
+#define EMITTER_HPP
+
+#include "Ball.hpp"
+#include <cstdint>
+#include <random>
+#include <eigen3/Eigen/Dense>
+
+// The generator's state words and its position among them, enough to
+// continue the exact same stream of random numbers.
+struct GeneratorState
+{
+    std::uint32_t words[std::mt19937::state_size];
+    std::uint32_t index;
+};
+
+class Emitter
+{
+public:
+    Emitter(Eigen::Vector3f positionInput=Eigen::Vector3f{0.0, 0.0, 0.0}, Eigen::Vector3f directionInput=Eigen::Vector3f{0.0, 0.0, 1.0}, float speedInput=20, float ballsPerSecondInput=5, unsigned int seedInput=1);
+
+    unsigned int advance(float deltaTime);
+    float get_spawn_age(unsigned int spawnIndex, unsigned int count);
+    Ball sample_ball();
+
+    Eigen::Vector3f get_position();
+    Eigen::Vector3f get_direction();
+    float get_speed();
+    float get_spread_angle();
+    float get_balls_per_second();
+    float get_min_radius();
+    float get_max_radius();
+    float get_min_mass();
+    float get_max_mass();
+    unsigned int get_min_color();
+    unsigned int get_max_color();
+    float get_min_coefficient_of_restitution();
+    float get_max_coefficient_of_restitution();
+    double get_emission_accumulator();
+    GeneratorState get_generator_state();
+
+    void set_position(Eigen::Vector3f newPosition);
+    void set_direction(Eigen::Vector3f newDirection);
+    void set_speed(float newSpeed);
+    void set_spread_angle(float newAngle);
+    void set_balls_per_second(float newRate);
+    void set_radius_range(float newMinRadius, float newMaxRadius);
+    void set_mass_range(float newMinMass, float newMaxMass);
+    void set_color_range(unsigned int newMinColor, unsigned int newMaxColor);
+    void set_coefficient_of_restitution_range(float newMinCoefficient, float newMaxCoefficient);
+    void set_emission_accumulator(double newAccumulator);
+    bool set_generator_state(const GeneratorState &newState);
+
+protected:
+    float sample_uniform(float minValue, float maxValue);
+
+    Eigen::Vector3f position{0.0, 0.0, 0.0};
+    Eigen::Vector3f direction{0.0, 0.0, 1.0};
+    float speed{20};
+    float spreadAngle{0};
+    float ballsPerSecond{5};
+    float minRadius{0.5};
+    float maxRadius{0.5};
+    float minMass{5};
+    float maxMass{5};
+    unsigned int minColor{0};
+    unsigned int maxColor{0};
+    float minCoefficientOfRestitution{0.7};
+    float maxCoefficientOfRestitution{0.7};
+
+    double emissionAccumulator{0};
+    std::mt19937 generator;
+};
+
+#endif
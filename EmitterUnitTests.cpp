@@ -0,0 +1,116 @@
+#include "gtest/gtest.h"
+#include "UnitTestUtils.hpp"
+#include "Emitter.hpp"
+
+#include <math.h>
+
+
+class EmitterTests : public ::testing::Test
+{
+protected:
+    Eigen::Vector3f position{1, 2, 3};
+    Eigen::Vector3f direction{0, 0, 2};
+    float speed{10};
+    float ballsPerSecond{100};
+    Emitter emitter{Emitter(position, direction, speed, ballsPerSecond)};
+};
+
+TEST_F(EmitterTests, WhenInitializingEmitter_ExpectCorrectParametersAndNormalizedDirection)
+{
+    EXPECT_VECTOR3_FLOAT_EQ(emitter.get_position(), position);
+    EXPECT_VECTOR3_FLOAT_EQ(emitter.get_direction(), Eigen::Vector3f(0, 0, 1));
+    EXPECT_EQ(emitter.get_speed(), speed);
+    EXPECT_EQ(emitter.get_balls_per_second(), ballsPerSecond);
+}
+
+TEST_F(EmitterTests, WhenAdvancingEmitter_ExpectRateTimesElapsedTimeBalls)
+{
+    unsigned int total{0};
+    for(int step{0}; step < 30; step++)
+        total += emitter.advance(1.0/30);
+
+    EXPECT_NEAR(total, ballsPerSecond, 1);
+}
+
+TEST_F(EmitterTests, WhenAdvancingEmitterWithZeroRate_ExpectNoBalls)
+{
+    emitter.set_balls_per_second(0);
+
+    EXPECT_EQ(emitter.advance(1), 0);
+}
+
+TEST_F(EmitterTests, WhenGettingSpawnAges_ExpectOldestFirstSpacedByEmissionPeriod)
+{
+    unsigned int count{emitter.advance(0.1)};
+
+    ASSERT_GT(count, 1);
+    EXPECT_GT(emitter.get_spawn_age(0, count), emitter.get_spawn_age(1, count));
+    EXPECT_NEAR(emitter.get_spawn_age(0, count) - emitter.get_spawn_age(1, count), 1/ballsPerSecond, 1e-6);
+    EXPECT_GE(emitter.get_spawn_age(count - 1, count), 0);
+}
+
+TEST_F(EmitterTests, WhenSamplingBallWithoutSpread_ExpectLaunchAlongDirection)
+{
+    Ball ball{emitter.sample_ball()};
+
+    EXPECT_VECTOR3_FLOAT_EQ(ball.position, position);
+    EXPECT_VECTOR3_FLOAT_EQ(ball.velocity, Eigen::Vector3f(0, 0, speed));
+}
+
+TEST_F(EmitterTests, WhenSamplingBallWithSpread_ExpectVelocityInsideCone)
+{
+    float spreadAngle{0.2};
+    emitter.set_spread_angle(spreadAngle);
+
+    for(int count{0}; count < 100; count++)
+    {
+        Ball ball{emitter.sample_ball()};
+        EXPECT_NEAR(ball.velocity.norm(), speed, 1e-4);
+        EXPECT_GE(ball.velocity.normalized().dot(emitter.get_direction()), cos(spreadAngle) - 1e-6);
+    }
+}
+
+TEST_F(EmitterTests, WhenSamplingBallWithRanges_ExpectParametersInsideRanges)
+{
+    emitter.set_radius_range(0.2, 0.4);
+    emitter.set_mass_range(1, 2);
+    emitter.set_color_range(10, 20);
+    emitter.set_coefficient_of_restitution_range(0.3, 0.6);
+
+    for(int count{0}; count < 100; count++)
+    {
+        Ball ball{emitter.sample_ball()};
+        EXPECT_GE(ball.radius, 0.2);
+        EXPECT_LE(ball.radius, 0.4);
+        EXPECT_GE(ball.mass, 1);
+        EXPECT_LE(ball.mass, 2);
+        EXPECT_GE(ball.color, 10);
+        EXPECT_LE(ball.color, 20);
+        EXPECT_GE(ball.coefficientOfRestitution, 0.3);
+        EXPECT_LE(ball.coefficientOfRestitution, 0.6);
+    }
+}
+
+TEST_F(EmitterTests, WhenRestoringGeneratorState_ExpectSameBallsAsOriginal)
+{
+    emitter.set_spread_angle(0.5);
+    for(int sample{0}; sample < 700; sample++)
+        emitter.sample_ball();
+    Emitter restored(position, direction, speed, ballsPerSecond, 99);
+    restored.set_spread_angle(0.5);
+
+    ASSERT_TRUE(restored.set_generator_state(emitter.get_generator_state()));
+
+    for(int sample{0}; sample < 10; sample++)
+        EXPECT_VECTOR3_FLOAT_EQ(restored.sample_ball().velocity, emitter.sample_ball().velocity);
+}
+
+TEST_F(EmitterTests, WhenRestoringInvalidGeneratorState_ExpectFailure)
+{
+    GeneratorState zeroState{};
+    GeneratorState badIndex{emitter.get_generator_state()};
+    badIndex.index = 10000;
+
+    EXPECT_FALSE(emitter.set_generator_state(zeroState));
+    EXPECT_FALSE(emitter.set_generator_state(badIndex));
+}
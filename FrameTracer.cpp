@@ -0,0 +1,165 @@
+#include "FrameTracer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+
+namespace frametracer
+{
+namespace
+{
+struct alignas(64) ThreadBuffer
+{
+    std::atomic<std::uint64_t> writeCount;
+};
+
+std::atomic<bool> recording{false};
+ThreadBuffer threadBuffers[maxThreadCount];
+std::vector<TraceEvent> events;
+unsigned int bufferCount{0};
+unsigned int bufferCapacity{0};
+std::atomic<unsigned int> threadsSeen{0};
+unsigned int session{0};
+std::uint64_t sessionStartTime{0};
+std::string exitPath;
+
+thread_local int threadSlot{-1};
+thread_local unsigned int threadSession{0};
+
+// Slots are handed out again on every start(). A thread arriving after
+// every buffer is taken gets -1 and its events are dropped.
+int get_thread_slot()
+{
+    if(threadSession != session)
+    {
+        unsigned int slot{threadsSeen.fetch_add(1, std::memory_order_relaxed)};
+        threadSlot = slot < bufferCount ? int(slot) : -1;
+        threadSession = session;
+    }
+    return threadSlot;
+}
+
+void write_json_at_exit_handler()
+{
+    write_json(exitPath);
+}
+}
+
+ScopedTrace::ScopedTrace(const char *nameInput)
+    : name{nameInput}, beginTime{recording.load(std::memory_order_relaxed) ? get_time() : 0}
+{
+}
+
+ScopedTrace::~ScopedTrace()
+{
+    if(beginTime != 0)
+        add_event(name, beginTime, get_time());
+}
+
+// The ring buffers are sized for about two threads per core; threads past
+// that are not traced.
+void start(unsigned int eventsPerThread)
+{
+    recording.store(false, std::memory_order_relaxed);
+    bufferCount = std::min(maxThreadCount, std::max(4u, 2*std::thread::hardware_concurrency() + 2));
+    bufferCapacity = std::max(eventsPerThread, 1u);
+    events.assign(std::size_t(bufferCount)*bufferCapacity, TraceEvent{nullptr, 0, 0});
+    for(ThreadBuffer &buffer : threadBuffers)
+        buffer.writeCount.store(0, std::memory_order_relaxed);
+    threadsSeen.store(0, std::memory_order_relaxed);
+    session++;
+    sessionStartTime = get_time();
+    recording.store(true, std::memory_order_release);
+}
+
+void stop()
+{
+    recording.store(false, std::memory_order_release);
+}
+
+bool is_recording()
+{
+    return recording.load(std::memory_order_relaxed);
+}
+
+// Recording pauses while the file is written so no buffer moves under it.
+// Timestamps are microseconds since start().
+bool write_json(const std::string &path)
+{
+    bool wasRecording{recording.exchange(false, std::memory_order_acquire)};
+    std::FILE *file{std::fopen(path.c_str(), "w")};
+    if(!file)
+    {
+        recording.store(wasRecording, std::memory_order_release);
+        return false;
+    }
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    const char *separator{""};
+    unsigned int slotCount{std::min(threadsSeen.load(std::memory_order_relaxed), bufferCount)};
+    for(unsigned int slot{0}; slot < slotCount; slot++)
+    {
+        std::uint64_t eventCount{threadBuffers[slot].writeCount.load(std::memory_order_acquire)};
+        std::fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}", separator, slot + 1, slot);
+        separator = ",";
+        std::uint64_t firstEvent{eventCount > bufferCapacity ? eventCount - bufferCapacity : 0};
+        for(std::uint64_t eventIndex{firstEvent}; eventIndex < eventCount; eventIndex++)
+        {
+            const TraceEvent &event = events[std::size_t(slot)*bufferCapacity + eventIndex % bufferCapacity];
+            std::fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"fountain\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         event.name, slot + 1, (event.beginTime - sessionStartTime)*1e-3, (event.endTime - event.beginTime)*1e-3);
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    bool written{std::fclose(file) == 0};
+    recording.store(wasRecording, std::memory_order_release);
+    return written;
+}
+
+void write_json_at_exit(const std::string &path)
+{
+    if(exitPath.empty())
+        std::atexit(write_json_at_exit_handler);
+    exitPath = path;
+}
+
+std::uint64_t get_time()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void add_event(const char *name, std::uint64_t beginTime, std::uint64_t endTime)
+{
+    if(!recording.load(std::memory_order_acquire))
+        return;
+    int slot{get_thread_slot()};
+    if(slot < 0)
+        return;
+    std::atomic<std::uint64_t> &writeCount = threadBuffers[slot].writeCount;
+    std::uint64_t eventIndex{writeCount.load(std::memory_order_relaxed)};
+    events[std::size_t(slot)*bufferCapacity + eventIndex % bufferCapacity] = TraceEvent{name, beginTime, endTime};
+    writeCount.store(eventIndex + 1, std::memory_order_release);
+}
+
+unsigned long get_event_count()
+{
+    unsigned long eventCount{0};
+    for(unsigned int slot{0}; slot < bufferCount; slot++)
+        eventCount += threadBuffers[slot].writeCount.load(std::memory_order_relaxed);
+    return eventCount;
+}
+
+unsigned long get_overwritten_event_count()
+{
+    unsigned long overwrittenCount{0};
+    for(unsigned int slot{0}; slot < bufferCount; slot++)
+    {
+        std::uint64_t eventCount{threadBuffers[slot].writeCount.load(std::memory_order_relaxed)};
+        overwrittenCount += eventCount > bufferCapacity ? eventCount - bufferCapacity : 0;
+    }
+    return overwrittenCount;
+}
+}
@@ -0,0 +1,56 @@
+#ifndef FRAME_TRACER_HPP
+#define FRAME_TRACER_HPP
+
+#include <cstdint>
+#include <string>
+
+// Opt-in timeline of traced scopes, written as Chrome trace-event JSON that
+// chrome://tracing and Perfetto open directly. Every thread writes complete
+// events into its own ring buffer, allocated up front by start(), so a
+// traced scope costs two clock reads and a store; when the ring is full the
+// oldest events are overwritten. While not recording a scope costs one
+// relaxed load.
+//
+// start(), stop() and write_json() are meant for the thread that drives the
+// simulation, between steps, when no other thread is inside a traced scope.
+namespace frametracer
+{
+const unsigned int maxThreadCount{64};
+
+struct TraceEvent
+{
+    const char *name;
+    std::uint64_t beginTime;
+    std::uint64_t endTime;
+};
+
+class ScopedTrace
+{
+public:
+    explicit ScopedTrace(const char *nameInput);
+    ~ScopedTrace();
+    ScopedTrace(const ScopedTrace &) = delete;
+    ScopedTrace& operator=(const ScopedTrace &) = delete;
+
+private:
+    const char *name;
+    std::uint64_t beginTime;
+};
+
+void start(unsigned int eventsPerThread=16384);
+void stop();
+bool is_recording();
+bool write_json(const std::string &path);
+void write_json_at_exit(const std::string &path);
+
+std::uint64_t get_time();
+void add_event(const char *name, std::uint64_t beginTime, std::uint64_t endTime);
+unsigned long get_event_count();
+unsigned long get_overwritten_event_count();
+}
+
+#define TRACE_SCOPE_NAME(line) traceScope##line
+#define TRACE_SCOPE_LINE(name, line) frametracer::ScopedTrace TRACE_SCOPE_NAME(line)(name)
+#define TRACE_SCOPE(name) TRACE_SCOPE_LINE(name, __LINE__)
+
+#endif
@@ -0,0 +1,123 @@
+#include "gtest/gtest.h"
+#include "FrameTracer.hpp"
+#include "BallPhysics.hpp"
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+
+class FrameTracerTests : public ::testing::Test
+{
+protected:
+    void SetUp();
+    void TearDown();
+    std::string read_trace();
+    unsigned int count_occurrences(const std::string &text, const std::string &pattern);
+
+    std::string path;
+};
+
+void FrameTracerTests::SetUp()
+{
+    path = ::testing::TempDir() + "FrameTracerTests_" + ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".json";
+}
+
+void FrameTracerTests::TearDown()
+{
+    frametracer::stop();
+    std::remove(path.c_str());
+}
+
+std::string FrameTracerTests::read_trace()
+{
+    std::ifstream file(path);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+unsigned int FrameTracerTests::count_occurrences(const std::string &text, const std::string &pattern)
+{
+    unsigned int count{0};
+    for(std::size_t position{text.find(pattern)}; position != std::string::npos; position = text.find(pattern, position + 1))
+        count++;
+    return count;
+}
+
+TEST_F(FrameTracerTests, WhenNotRecording_ExpectNoEvents)
+{
+    frametracer::start();
+    frametracer::stop();
+    {
+        TRACE_SCOPE("ignored");
+    }
+
+    EXPECT_FALSE(frametracer::is_recording());
+    EXPECT_EQ(frametracer::get_event_count(), 0);
+}
+
+TEST_F(FrameTracerTests, WhenScopesTracedOnTwoThreads_ExpectCompleteEventsPerThread)
+{
+    frametracer::start();
+    {
+        TRACE_SCOPE("main_scope");
+    }
+    std::thread worker([]
+    {
+        TRACE_SCOPE("worker_scope");
+    });
+    worker.join();
+
+    ASSERT_TRUE(frametracer::write_json(path));
+
+    std::string trace{read_trace()};
+    EXPECT_EQ(trace.compare(0, 47, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n{\"name\""), 0);
+    EXPECT_EQ(trace.substr(trace.size() - 4), "\n]}\n");
+    EXPECT_NE(trace.find("{\"name\":\"main_scope\",\"cat\":\"fountain\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"), std::string::npos);
+    EXPECT_NE(trace.find("{\"name\":\"worker_scope\",\"cat\":\"fountain\",\"ph\":\"X\",\"pid\":1,\"tid\":2,"), std::string::npos);
+    EXPECT_EQ(count_occurrences(trace, "\"ph\":\"M\""), 2);
+    EXPECT_TRUE(frametracer::is_recording());
+}
+
+TEST_F(FrameTracerTests, WhenRingBufferFull_ExpectOldestEventsOverwritten)
+{
+    frametracer::start(8);
+    const char *names[]{"first", "second"};
+    for(int event{0}; event < 20; event++)
+        frametracer::add_event(names[event >= 12], 1 + event, 2 + event);
+
+    ASSERT_TRUE(frametracer::write_json(path));
+
+    std::string trace{read_trace()};
+    EXPECT_EQ(frametracer::get_event_count(), 20);
+    EXPECT_EQ(frametracer::get_overwritten_event_count(), 12);
+    EXPECT_EQ(count_occurrences(trace, "\"ph\":\"X\""), 8);
+    EXPECT_EQ(trace.find("\"first\""), std::string::npos);
+}
+
+TEST_F(FrameTracerTests, WhenSteppingPhysicsWhileRecording_ExpectStepAndCollisionEvents)
+{
+    BallPhysics fountain(10, 1.2, -9.81, 200);
+    fountain.set_thread_count(2);
+    fountain.add_emitter(Emitter(Eigen::Vector3f{0, 0, 0.5}, Eigen::Vector3f{0, 0, 1}, 15, 400));
+    fountain.update(1.0/120);
+    frametracer::start();
+    for(int step{0}; step < 30; step++)
+        fountain.update(1.0/120);
+    frametracer::stop();
+
+    ASSERT_TRUE(frametracer::write_json(path));
+
+    std::string trace{read_trace()};
+    EXPECT_EQ(count_occurrences(trace, "\"BallPhysics::update\""), 30);
+    EXPECT_EQ(count_occurrences(trace, "\"BallPhysics::update_ball_collisions\""), 30);
+    EXPECT_EQ(count_occurrences(trace, "\"BallPhysics::emit_balls\""), 30);
+    EXPECT_GE(count_occurrences(trace, "\"BallPhysics::integrate_balls\""), 30);
+    EXPECT_FALSE(frametracer::is_recording());
+}
+
+TEST_F(FrameTracerTests, WhenWritingToMissingDirectory_ExpectFailureAndRecordingKept)
+{
+    frametracer::start();
+
+    EXPECT_FALSE(frametracer::write_json(path + ".missing/trace.json"));
+    EXPECT_TRUE(frametracer::is_recording());
+}
@@ -0,0 +1,104 @@
+#include "InstancedSphereGeometry.hpp"
+
+#include <osg/PrimitiveSet>
+#include <osg/Program>
+#include <osg/Shader>
+#include <osg/StateSet>
+#include <osg/VertexAttribDivisor>
+
+#include <math.h>
+
+namespace instancedsphere
+{
+
+static const char *vertexShaderSource =
+    "#version 120\n"
+    "attribute vec4 instancePositionRadius;\n"
+    "attribute vec4 instanceColor;\n"
+    "varying vec3 eyeNormal;\n"
+    "varying vec4 ballColor;\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 worldVertex = vec4(gl_Vertex.xyz*instancePositionRadius.w + instancePositionRadius.xyz, 1.0);\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix*worldVertex;\n"
+    "    eyeNormal = normalize(gl_NormalMatrix*gl_Normal);\n"
+    "    ballColor = instanceColor;\n"
+    "}\n";
+
+static const char *fragmentShaderSource =
+    "#version 120\n"
+    "varying vec3 eyeNormal;\n"
+    "varying vec4 ballColor;\n"
+    "void main()\n"
+    "{\n"
+    "    vec3 lightDirection = normalize(vec3(0.0, 0.0, 1.0));\n"
+    "    float diffuse = max(dot(normalize(eyeNormal), lightDirection), 0.0);\n"
+    "    gl_FragColor = vec4(ballColor.rgb*(0.3 + 0.7*diffuse), ballColor.a);\n"
+    "}\n";
+
+// One unit sphere mesh drawn once per ball. Per-ball position, radius and
+// color come from two vertex attribute arrays advanced once per instance.
+osg::Geode* create_instanced_sphere_geode(unsigned int stackCount, unsigned int sliceCount)
+{
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    for(unsigned int stack{0}; stack <= stackCount; stack++)
+    {
+        float polarAngle{float(M_PI*stack/stackCount)};
+        for(unsigned int slice{0}; slice <= sliceCount; slice++)
+        {
+            float azimuthAngle{float(2*M_PI*slice/sliceCount)};
+            vertices->push_back(osg::Vec3(sin(polarAngle)*cos(azimuthAngle), sin(polarAngle)*sin(azimuthAngle), cos(polarAngle)));
+        }
+    }
+    osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array(*vertices);
+
+    osg::ref_ptr<osg::DrawElementsUShort> triangles = new osg::DrawElementsUShort(GL_TRIANGLES);
+    for(unsigned int stack{0}; stack < stackCount; stack++)
+    {
+        for(unsigned int slice{0}; slice < sliceCount; slice++)
+        {
+            unsigned short topLeft(stack*(sliceCount + 1) + slice);
+            unsigned short bottomLeft(topLeft + sliceCount + 1);
+            triangles->push_back(topLeft);
+            triangles->push_back(bottomLeft);
+            triangles->push_back(topLeft + 1);
+            triangles->push_back(topLeft + 1);
+            triangles->push_back(bottomLeft);
+            triangles->push_back(bottomLeft + 1);
+        }
+    }
+    triangles->setNumInstances(1);
+
+    osg::ref_ptr<osg::Vec4Array> instancePositionRadii = new osg::Vec4Array(1);
+    osg::ref_ptr<osg::Vec4Array> instanceColors = new osg::Vec4Array(1);
+    instancePositionRadii->setDataVariance(osg::Object::DYNAMIC);
+    instanceColors->setDataVariance(osg::Object::DYNAMIC);
+
+    osg::Geometry* sphereGeometry = new osg::Geometry;
+    sphereGeometry->setName("InstancedSpheres");
+    sphereGeometry->setDataVariance(osg::Object::DYNAMIC);
+    sphereGeometry->setUseDisplayList(false);
+    sphereGeometry->setUseVertexBufferObjects(true);
+    sphereGeometry->setVertexArray(vertices.get());
+    sphereGeometry->setNormalArray(normals.get(), osg::Array::BIND_PER_VERTEX);
+    sphereGeometry->setVertexAttribArray(positionRadiusAttribute, instancePositionRadii.get(), osg::Array::BIND_PER_VERTEX);
+    sphereGeometry->setVertexAttribArray(colorAttribute, instanceColors.get(), osg::Array::BIND_PER_VERTEX);
+    sphereGeometry->addPrimitiveSet(triangles.get());
+
+    osg::Program* program = new osg::Program;
+    program->addShader(new osg::Shader(osg::Shader::VERTEX, vertexShaderSource));
+    program->addShader(new osg::Shader(osg::Shader::FRAGMENT, fragmentShaderSource));
+    program->addBindAttribLocation("instancePositionRadius", positionRadiusAttribute);
+    program->addBindAttribLocation("instanceColor", colorAttribute);
+
+    osg::Geode* sphereGeode = new osg::Geode;
+    sphereGeode->addDrawable(sphereGeometry);
+    osg::StateSet* stateSetSpheres = sphereGeode->getOrCreateStateSet();
+    stateSetSpheres->setAttributeAndModes(program, osg::StateAttribute::ON);
+    stateSetSpheres->setAttributeAndModes(new osg::VertexAttribDivisor(positionRadiusAttribute, 1));
+    stateSetSpheres->setAttributeAndModes(new osg::VertexAttribDivisor(colorAttribute, 1));
+    stateSetSpheres->setMode(GL_DEPTH_TEST, osg::StateAttribute::ON);
+    return sphereGeode;
+}
+
+}
@@ -0,0 +1,14 @@
+#ifndef INSTANCED_SPHERE_GEOMETRY_HPP
+#define INSTANCED_SPHERE_GEOMETRY_HPP
+
+#include <osg/Geode>
+#include <osg/Geometry>
+
+namespace instancedsphere
+{
+    const unsigned int positionRadiusAttribute{6};
+    const unsigned int colorAttribute{7};
+
+    osg::Geode* create_instanced_sphere_geode(unsigned int stackCount=12, unsigned int sliceCount=16);
+}
+#endif
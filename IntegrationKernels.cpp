@@ -0,0 +1,149 @@
+#include "IntegrationKernels.hpp"
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define INTEGRATION_KERNELS_AVX2
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define INTEGRATION_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace integrationkernels
+{
+
+// Gravity plus quadratic drag, a = g - k|v|v with k = 0.5*rho*Cd*A/m cached
+// per ball, so a resting ball needs no special case.
+void integrate_scalar(BallStorage &balls, unsigned int firstIndex, unsigned int lastIndex, float gravity, float deltaTime)
+{
+    float halfDeltaTimeSquared{0.5f*deltaTime*deltaTime};
+    for(unsigned int index{firstIndex}; index < lastIndex; index++)
+    {
+        float velocityX{balls.velocityX[index]};
+        float velocityY{balls.velocityY[index]};
+        float velocityZ{balls.velocityZ[index]};
+        float speed{sqrtf(velocityX*velocityX + velocityY*velocityY + velocityZ*velocityZ)};
+        float drag{balls.dragConstant[index]*speed};
+        float accelerationX{-drag*velocityX};
+        float accelerationY{-drag*velocityY};
+        float accelerationZ{gravity - drag*velocityZ};
+        velocityX += accelerationX*deltaTime;
+        velocityY += accelerationY*deltaTime;
+        velocityZ += accelerationZ*deltaTime;
+        balls.positionX[index] += velocityX*deltaTime + accelerationX*halfDeltaTimeSquared;
+        balls.positionY[index] += velocityY*deltaTime + accelerationY*halfDeltaTimeSquared;
+        balls.positionZ[index] += velocityZ*deltaTime + accelerationZ*halfDeltaTimeSquared;
+        balls.velocityX[index] = velocityX;
+        balls.velocityY[index] = velocityY;
+        balls.velocityZ[index] = velocityZ;
+        balls.accelerationX[index] = accelerationX;
+        balls.accelerationY[index] = accelerationY;
+        balls.accelerationZ[index] = accelerationZ;
+    }
+}
+
+#if defined(INTEGRATION_KERNELS_AVX2)
+
+bool has_simd_support()
+{
+    return __builtin_cpu_supports("avx2");
+}
+
+__attribute__((target("avx2")))
+void integrate_simd(BallStorage &balls, unsigned int firstIndex, unsigned int lastIndex, float gravity, float deltaTime)
+{
+    const __m256 gravityLane{_mm256_set1_ps(gravity)};
+    const __m256 deltaTimeLane{_mm256_set1_ps(deltaTime)};
+    const __m256 halfDeltaTimeSquaredLane{_mm256_set1_ps(0.5f*deltaTime*deltaTime)};
+    unsigned int index{firstIndex};
+    for(; index + 8 <= lastIndex; index += 8)
+    {
+        __m256 velocityX{_mm256_loadu_ps(&balls.velocityX[index])};
+        __m256 velocityY{_mm256_loadu_ps(&balls.velocityY[index])};
+        __m256 velocityZ{_mm256_loadu_ps(&balls.velocityZ[index])};
+        __m256 speedSquared{_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(velocityX, velocityX), _mm256_mul_ps(velocityY, velocityY)), _mm256_mul_ps(velocityZ, velocityZ))};
+        __m256 drag{_mm256_mul_ps(_mm256_loadu_ps(&balls.dragConstant[index]), _mm256_sqrt_ps(speedSquared))};
+        __m256 accelerationX{_mm256_sub_ps(_mm256_setzero_ps(), _mm256_mul_ps(drag, velocityX))};
+        __m256 accelerationY{_mm256_sub_ps(_mm256_setzero_ps(), _mm256_mul_ps(drag, velocityY))};
+        __m256 accelerationZ{_mm256_sub_ps(gravityLane, _mm256_mul_ps(drag, velocityZ))};
+        velocityX = _mm256_add_ps(velocityX, _mm256_mul_ps(accelerationX, deltaTimeLane));
+        velocityY = _mm256_add_ps(velocityY, _mm256_mul_ps(accelerationY, deltaTimeLane));
+        velocityZ = _mm256_add_ps(velocityZ, _mm256_mul_ps(accelerationZ, deltaTimeLane));
+        __m256 stepX{_mm256_add_ps(_mm256_mul_ps(velocityX, deltaTimeLane), _mm256_mul_ps(accelerationX, halfDeltaTimeSquaredLane))};
+        __m256 stepY{_mm256_add_ps(_mm256_mul_ps(velocityY, deltaTimeLane), _mm256_mul_ps(accelerationY, halfDeltaTimeSquaredLane))};
+        __m256 stepZ{_mm256_add_ps(_mm256_mul_ps(velocityZ, deltaTimeLane), _mm256_mul_ps(accelerationZ, halfDeltaTimeSquaredLane))};
+        _mm256_storeu_ps(&balls.positionX[index], _mm256_add_ps(_mm256_loadu_ps(&balls.positionX[index]), stepX));
+        _mm256_storeu_ps(&balls.positionY[index], _mm256_add_ps(_mm256_loadu_ps(&balls.positionY[index]), stepY));
+        _mm256_storeu_ps(&balls.positionZ[index], _mm256_add_ps(_mm256_loadu_ps(&balls.positionZ[index]), stepZ));
+        _mm256_storeu_ps(&balls.velocityX[index], velocityX);
+        _mm256_storeu_ps(&balls.velocityY[index], velocityY);
+        _mm256_storeu_ps(&balls.velocityZ[index], velocityZ);
+        _mm256_storeu_ps(&balls.accelerationX[index], accelerationX);
+        _mm256_storeu_ps(&balls.accelerationY[index], accelerationY);
+        _mm256_storeu_ps(&balls.accelerationZ[index], accelerationZ);
+    }
+    integrate_scalar(balls, index, lastIndex, gravity, deltaTime);
+}
+
+#elif defined(INTEGRATION_KERNELS_NEON)
+
+bool has_simd_support()
+{
+    return true;
+}
+
+void integrate_simd(BallStorage &balls, unsigned int firstIndex, unsigned int lastIndex, float gravity, float deltaTime)
+{
+    const float32x4_t gravityLane{vdupq_n_f32(gravity)};
+    const float32x4_t deltaTimeLane{vdupq_n_f32(deltaTime)};
+    const float32x4_t halfDeltaTimeSquaredLane{vdupq_n_f32(0.5f*deltaTime*deltaTime)};
+    unsigned int index{firstIndex};
+    for(; index + 4 <= lastIndex; index += 4)
+    {
+        float32x4_t velocityX{vld1q_f32(&balls.velocityX[index])};
+        float32x4_t velocityY{vld1q_f32(&balls.velocityY[index])};
+        float32x4_t velocityZ{vld1q_f32(&balls.velocityZ[index])};
+        float32x4_t speedSquared{vaddq_f32(vaddq_f32(vmulq_f32(velocityX, velocityX), vmulq_f32(velocityY, velocityY)), vmulq_f32(velocityZ, velocityZ))};
+        float32x4_t drag{vmulq_f32(vld1q_f32(&balls.dragConstant[index]), vsqrtq_f32(speedSquared))};
+        float32x4_t accelerationX{vnegq_f32(vmulq_f32(drag, velocityX))};
+        float32x4_t accelerationY{vnegq_f32(vmulq_f32(drag, velocityY))};
+        float32x4_t accelerationZ{vsubq_f32(gravityLane, vmulq_f32(drag, velocityZ))};
+        velocityX = vaddq_f32(velocityX, vmulq_f32(accelerationX, deltaTimeLane));
+        velocityY = vaddq_f32(velocityY, vmulq_f32(accelerationY, deltaTimeLane));
+        velocityZ = vaddq_f32(velocityZ, vmulq_f32(accelerationZ, deltaTimeLane));
+        float32x4_t stepX{vaddq_f32(vmulq_f32(velocityX, deltaTimeLane), vmulq_f32(accelerationX, halfDeltaTimeSquaredLane))};
+        float32x4_t stepY{vaddq_f32(vmulq_f32(velocityY, deltaTimeLane), vmulq_f32(accelerationY, halfDeltaTimeSquaredLane))};
+        float32x4_t stepZ{vaddq_f32(vmulq_f32(velocityZ, deltaTimeLane), vmulq_f32(accelerationZ, halfDeltaTimeSquaredLane))};
+        vst1q_f32(&balls.positionX[index], vaddq_f32(vld1q_f32(&balls.positionX[index]), stepX));
+        vst1q_f32(&balls.positionY[index], vaddq_f32(vld1q_f32(&balls.positionY[index]), stepY));
+        vst1q_f32(&balls.positionZ[index], vaddq_f32(vld1q_f32(&balls.positionZ[index]), stepZ));
+        vst1q_f32(&balls.velocityX[index], velocityX);
+        vst1q_f32(&balls.velocityY[index], velocityY);
+        vst1q_f32(&balls.velocityZ[index], velocityZ);
+        vst1q_f32(&balls.accelerationX[index], accelerationX);
+        vst1q_f32(&balls.accelerationY[index], accelerationY);
+        vst1q_f32(&balls.accelerationZ[index], accelerationZ);
+    }
+    integrate_scalar(balls, index, lastIndex, gravity, deltaTime);
+}
+
+#else
+
+bool has_simd_support()
+{
+    return false;
+}
+
+void integrate_simd(BallStorage &balls, unsigned int firstIndex, unsigned int lastIndex, float gravity, float deltaTime)
+{
+    integrate_scalar(balls, firstIndex, lastIndex, gravity, deltaTime);
+}
+
+#endif
+
+IntegrateFunction select_integrate_function()
+{
+    return has_simd_support() ? &integrate_simd : &integrate_scalar;
+}
+
+}
@@ -0,0 +1,15 @@
+#ifndef INTEGRATION_KERNELS_HPP
+#define INTEGRATION_KERNELS_HPP
+
+#include "BallStorage.hpp"
+
+namespace integrationkernels
+{
+    typedef void (*IntegrateFunction)(BallStorage &balls, unsigned int firstIndex, unsigned int lastIndex, float gravity, float deltaTime);
+
+    void integrate_scalar(BallStorage &balls, unsigned int firstIndex, unsigned int lastIndex, float gravity, float deltaTime);
+    bool has_simd_support();
+    void integrate_simd(BallStorage &balls, unsigned int firstIndex, unsigned int lastIndex, float gravity, float deltaTime);
+    IntegrateFunction select_integrate_function();
+}
+#endif
@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+#include "IntegrationKernels.hpp"
+
+#include <random>
+
+
+class IntegrationKernelsTests : public ::testing::Test
+{
+protected:
+    void add_random_balls(BallStorage &storage, int count);
+    BallStorage scalarBalls;
+    BallStorage simdBalls;
+    float gravity{-9.81};
+    float deltaTime{0.01};
+};
+
+void IntegrationKernelsTests::add_random_balls(BallStorage &storage, int count)
+{
+    std::mt19937 generator{11};
+    std::uniform_real_distribution<float> coordinate{-20, 20};
+    std::uniform_real_distribution<float> dragConstant{0, 0.2};
+    for(int index{0}; index < count; index++)
+    {
+        Ball ball;
+        ball.position = Eigen::Vector3f{coordinate(generator), coordinate(generator), coordinate(generator)};
+        ball.velocity = Eigen::Vector3f{coordinate(generator), coordinate(generator), coordinate(generator)};
+        storage.push_back(ball);
+        storage.dragConstant[index] = dragConstant(generator);
+    }
+}
+
+TEST_F(IntegrationKernelsTests, WhenIntegratingWithoutDrag_ExpectBallisticMotion)
+{
+    Ball ball;
+    ball.position = Eigen::Vector3f{1, 2, 3};
+    ball.velocity = Eigen::Vector3f{1, 0, 0};
+    scalarBalls.push_back(ball);
+
+    integrationkernels::integrate_scalar(scalarBalls, 0, 1, gravity, 1);
+
+    EXPECT_FLOAT_EQ(scalarBalls.positionX[0], 2);
+    EXPECT_FLOAT_EQ(scalarBalls.positionZ[0], 3 + gravity + 0.5*gravity);
+    EXPECT_FLOAT_EQ(scalarBalls.velocityZ[0], gravity);
+    EXPECT_FLOAT_EQ(scalarBalls.accelerationZ[0], gravity);
+}
+
+TEST_F(IntegrationKernelsTests, WhenIntegratingWithDrag_ExpectAccelerationOpposingVelocity)
+{
+    Ball ball;
+    ball.velocity = Eigen::Vector3f{3, 0, 4};
+    scalarBalls.push_back(ball);
+    scalarBalls.dragConstant[0] = 0.1;
+
+    integrationkernels::integrate_scalar(scalarBalls, 0, 1, 0, 0);
+
+    EXPECT_FLOAT_EQ(scalarBalls.accelerationX[0], -0.1*5*3);
+    EXPECT_FLOAT_EQ(scalarBalls.accelerationZ[0], -0.1*5*4);
+}
+
+TEST_F(IntegrationKernelsTests, WhenIntegratingWithSimdKernel_ExpectSameResultAsScalarKernel)
+{
+    int count{1003};
+    add_random_balls(scalarBalls, count);
+    add_random_balls(simdBalls, count);
+
+    for(int step{0}; step < 10; step++)
+    {
+        integrationkernels::integrate_scalar(scalarBalls, 0, count, gravity, deltaTime);
+        integrationkernels::integrate_simd(simdBalls, 0, count, gravity, deltaTime);
+    }
+
+    for(int index{0}; index < count; index++)
+    {
+        EXPECT_FLOAT_EQ(simdBalls.positionX[index], scalarBalls.positionX[index]);
+        EXPECT_FLOAT_EQ(simdBalls.positionY[index], scalarBalls.positionY[index]);
+        EXPECT_FLOAT_EQ(simdBalls.positionZ[index], scalarBalls.positionZ[index]);
+        EXPECT_FLOAT_EQ(simdBalls.velocityX[index], scalarBalls.velocityX[index]);
+        EXPECT_FLOAT_EQ(simdBalls.velocityY[index], scalarBalls.velocityY[index]);
+        EXPECT_FLOAT_EQ(simdBalls.velocityZ[index], scalarBalls.velocityZ[index]);
+    }
+}
+
+TEST_F(IntegrationKernelsTests, WhenSelectingKernel_ExpectSimdKernelOnlyWhenSupported)
+{
+    integrationkernels::IntegrateFunction expected{integrationkernels::has_simd_support() ? &integrationkernels::integrate_simd : &integrationkernels::integrate_scalar};
+
+    EXPECT_EQ(integrationkernels::select_integrate_function(), expected);
+}
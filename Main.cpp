@@ -1,9 +1,19 @@
 #include "MainWindow.hpp"
+#include "FrameTracer.hpp"
 #include <QApplication>
+#include <cstdlib>
 
 int main(int argc, char *argv[])
 {
   QApplication a(argc, argv);
+  // Setting PHYSICS_FOUNTAIN_TRACE to a file path traces the whole run and
+  // writes it there on exit.
+  const char *tracePath{std::getenv("PHYSICS_FOUNTAIN_TRACE")};
+  if(tracePath && *tracePath)
+  {
+    frametracer::start();
+    frametracer::write_json_at_exit(tracePath);
+  }
   MainWindow w;
   w.show();
 
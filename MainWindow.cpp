@@ -1,23 +1,157 @@
 #include "MainWindow.hpp"
 #include "ui_MainWindowForm.h"
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QSignalBlocker>
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow{parent},
     mMainWindowUI{new Ui::MainWindowForm}
 {
     mMainWindowUI->setupUi(this);
+    mMainWindowUI->actionExport_Profile->setEnabled(phaseprofiler::enabled);
+    timelineTimerId = startTimer(1000.0/timelineUpdatesPerSecond);
 }
 
 MainWindow::~MainWindow()
 {
+    killTimer(timelineTimerId);
     delete mMainWindowUI;
 }
 
+void MainWindow::timerEvent(QTimerEvent *event)
+{
+    if(event->timerId() != timelineTimerId)
+        return;
+    update_timeline();
+    if(phaseprofiler::enabled)
+        statusBar()->showMessage(QString::fromStdString(phaseprofiler::format_frame(phaseprofiler::get_last_frame())));
+}
+
 void MainWindow::on_actionExit_triggered()
 {
     QApplication::quit();
 }
 
+void MainWindow::on_actionOpen_triggered()
+{
+    QString path{QFileDialog::getOpenFileName(this, QString("Open Scene"), sceneFilePath, QString("Fountain Scenes (*.scene)"))};
+    if(path.isEmpty())
+        return;
+    OSGWidget *osgWidget = qobject_cast<OSGWidget *>(findChild<QObject *>("graphicsView"));
+    if(!osgWidget->load_scene(path.toStdString()))
+    {
+        QMessageBox::warning(this, QString("Open Scene"), QString("Could not open %1 as a fountain scene.").arg(path));
+        return;
+    }
+    sceneFilePath = path;
+    update_sliders_from_simulation();
+}
+
+void MainWindow::on_actionSave_triggered()
+{
+    if(sceneFilePath.isEmpty())
+    {
+        on_actionSave_As_triggered();
+        return;
+    }
+    OSGWidget *osgWidget = qobject_cast<OSGWidget *>(findChild<QObject *>("graphicsView"));
+    if(!osgWidget->save_scene(sceneFilePath.toStdString()))
+        QMessageBox::warning(this, QString("Save Scene"), QString("Could not save %1.").arg(sceneFilePath));
+}
+
+void MainWindow::on_actionSave_As_triggered()
+{
+    QString path{QFileDialog::getSaveFileName(this, QString("Save Scene"), sceneFilePath, QString("Fountain Scenes (*.scene)"))};
+    if(path.isEmpty())
+        return;
+    if(!path.endsWith(QString(".scene")))
+        path += QString(".scene");
+    sceneFilePath = path;
+    on_actionSave_triggered();
+}
+
+void MainWindow::on_actionExport_Profile_triggered()
+{
+    QString path{QFileDialog::getSaveFileName(this, QString("Export Frame Profile"), QString(), QString("Comma Separated Values (*.csv)"))};
+    if(path.isEmpty())
+        return;
+    if(!path.endsWith(QString(".csv")))
+        path += QString(".csv");
+    if(!phaseprofiler::write_csv(path.toStdString()))
+        QMessageBox::warning(this, QString("Export Frame Profile"), QString("Could not write %1.").arg(path));
+}
+
+// Starts a fresh trace when checked; unchecking stops it and asks where to
+// write it.
+void MainWindow::on_actionRecord_Trace_toggled(bool checked)
+{
+    if(checked)
+    {
+        frametracer::start();
+        return;
+    }
+    frametracer::stop();
+    QString path{QFileDialog::getSaveFileName(this, QString("Save Trace"), QString(), QString("Chrome Trace Events (*.json)"))};
+    if(path.isEmpty())
+        return;
+    if(!path.endsWith(QString(".json")))
+        path += QString(".json");
+    if(!frametracer::write_json(path.toStdString()))
+        QMessageBox::warning(this, QString("Save Trace"), QString("Could not write %1.").arg(path));
+}
+
+// Moves the sliders to a loaded scene's parameters without feeding them
+// back into the simulation.
+void MainWindow::update_sliders_from_simulation()
+{
+    OSGWidget *osgWidget = qobject_cast<OSGWidget *>(findChild<QObject *>("graphicsView"));
+    BallPhysics *physics = osgWidget->get_physics_ptr();
+    const int sliderValues[]{int(lround(physics->get_new_ball_mass())),
+                             int(lround(physics->get_new_ball_radius()*100)),
+                             int(lround(physics->get_new_ball_velocity()[2])),
+                             int(physics->get_new_ball_color()),
+                             int(lround(osgWidget->get_ball_rate())),
+                             int(lround(physics->get_fluid_density()*100)),
+                             int(lround(physics->get_gravity()/-9.81*10)),
+                             int(lround(physics->get_new_ball_coefficient_of_restitution()*100))};
+    const char *sliderNames[]{"horizontalSlider_BallMass", "horizontalSlider_BallSize", "horizontalSlider_BallVelocity", "horizontalSlider_BallColor",
+                              "horizontalSlider_BallFrequency", "horizontalSlider_FluidViscosity", "horizontalSlider_Gravity", "horizontalSlider_BallBounciness"};
+    for(unsigned int sliderIndex{0}; sliderIndex < 8; sliderIndex++)
+    {
+        QSlider *slider = qobject_cast<QSlider *>(findChild<QObject *>(sliderNames[sliderIndex]));
+        QSignalBlocker blocker(slider);
+        slider->setSliderPosition(sliderValues[sliderIndex]);
+    }
+}
+
+// Stretches the timeline over the recorded steps and follows the current
+// step, unless the user is dragging it.
+void MainWindow::update_timeline()
+{
+    OSGWidget *osgWidget = qobject_cast<OSGWidget *>(findChild<QObject *>("graphicsView"));
+    SimulationHistory *history = osgWidget->get_history_ptr();
+    QSlider *timelineSlider = qobject_cast<QSlider *>(findChild<QObject *>("horizontalSlider_Timeline"));
+    QLabel *timelineLabel = qobject_cast<QLabel *>(findChild<QObject *>("label_Timeline"));
+    unsigned long step{osgWidget->get_physics_ptr()->get_step_count()};
+    timelineLabel->setText(QString("Step %1").arg(step));
+    if(timelineSlider->isSliderDown())
+        return;
+    QSignalBlocker blocker(timelineSlider);
+    timelineSlider->setRange(int(history->get_first_step()), int(history->get_last_step()));
+    timelineSlider->setSliderPosition(int(step));
+}
+
+void MainWindow::on_horizontalSlider_Timeline_valueChanged(int newStep)
+{
+    OSGWidget *osgWidget = qobject_cast<OSGWidget *>(findChild<QObject *>("graphicsView"));
+    QPushButton *pausePlayButton = qobject_cast<QPushButton *>(findChild<QObject *>("pushButton_Pause"));
+    pausePlayButton->setChecked(true);
+    if(osgWidget->seek_step(newStep))
+        update_sliders_from_simulation();
+    update_timeline();
+}
+
 void MainWindow::on_horizontalSlider_BallMass_valueChanged(int newMass)
 {
     OSGWidget *osgWidget = qobject_cast<OSGWidget *>(findChild<QObject *>("graphicsView"));
@@ -47,7 +181,6 @@ void MainWindow::on_horizontalSlider_BallFrequency_valueChanged(int newFrequency
 {
     OSGWidget *osgWidget = qobject_cast<OSGWidget *>(findChild<QObject *>("graphicsView"));
     osgWidget->set_ball_rate(newFrequency);
-    osgWidget->update_ball_update_rate();
 }
 
 void MainWindow::on_horizontalSlider_FluidViscosity_valueChanged(int newFluidDensity)
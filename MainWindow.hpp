@@ -21,6 +21,16 @@ public:
 private slots:
     void on_actionExit_triggered();
 
+    void on_actionOpen_triggered();
+
+    void on_actionSave_triggered();
+
+    void on_actionSave_As_triggered();
+
+    void on_actionExport_Profile_triggered();
+
+    void on_actionRecord_Trace_toggled(bool checked);
+
     void on_horizontalSlider_BallMass_valueChanged(int newMass);
 
     void on_horizontalSlider_BallSize_valueChanged(int newRadius);
@@ -43,8 +53,19 @@ private slots:
 
     void on_pushButton_Pause_toggled(bool checked);
 
+    void on_horizontalSlider_Timeline_valueChanged(int newStep);
+
+protected:
+    void timerEvent(QTimerEvent *event);
+
 private:
+    void update_sliders_from_simulation();
+    void update_timeline();
+
     Ui::MainWindowForm *mMainWindowUI;
+    QString sceneFilePath;
+    int timelineTimerId{0};
+    double timelineUpdatesPerSecond{10};
 };
 
 #endif
@@ -13,29 +13,42 @@ OSGWidget::OSGWidget(QWidget* parent, Qt::WindowFlags flags):
     camera{new osg::Camera},
     manipulator{new osgGA::TrackballManipulator}
 {
+    physics.set_thread_count(std::thread::hardware_concurrency());
+    nozzleEmitterIndex = physics.add_emitter(Emitter());
+    update_nozzle_emitter();
     create_camera();
     create_manipulator();
     create_view();
     create_viewer();
     add_cylinder();
     add_ground_plane();
+    add_ball_spheres();
     configure_update();
 }
 
 OSGWidget::~OSGWidget()
 {
     killTimer(simulationUpdateTimerId);
-    killTimer(ballUpdateTimerId);
 }
 
 void OSGWidget::timerEvent(QTimerEvent *event)
 {
-    if(!pauseFlag)
+    if(!pauseFlag && event->timerId() == simulationUpdateTimerId)
     {
-        if(event->timerId() == simulationUpdateTimerId)
-            physics.update(1/framesPerSecond);
-        else if(event->timerId() == ballUpdateTimerId)
-            add_ball();
+        TRACE_SCOPE("OSGWidget::timerEvent");
+        unsigned int steps{simulationClock.tick()};
+        for(unsigned int step{0}; step < steps; step++)
+        {
+            if(historyNeedsKeyframe)
+            {
+                history.capture(physics, simulationClock.get_fixed_time_step());
+                historyNeedsKeyframe = false;
+            }
+            physics.update(simulationClock.get_fixed_time_step());
+            history.record(physics, simulationClock.get_fixed_time_step());
+        }
+        if(steps > 0)
+            physics.publish_snapshot();
     }
     update();
 }
@@ -50,9 +63,45 @@ void OSGWidget::paintEvent(QPaintEvent* /* paintEvent */)
     this->doneCurrent();
 }
 
+// The same traversals as mViewer->frame(), called one by one so update and
+// draw can be timed apart. The first frame goes through frame() for the
+// viewer's one-time setup.
 void OSGWidget::paintGL()
 {
-    mViewer->frame();
+    TRACE_SCOPE("OSGWidget::paintGL");
+    physics.get_snapshot_buffer()->acquire_latest();
+    if(!viewerStarted || mViewer->done())
+    {
+        mViewer->frame();
+        viewerStarted = true;
+        return;
+    }
+    mViewer->advance();
+    mViewer->eventTraversal();
+    {
+        PROFILE_PHASE(phaseprofiler::updateTraversal);
+        TRACE_SCOPE("osgViewer::updateTraversal");
+        mViewer->updateTraversal();
+    }
+    {
+        PROFILE_PHASE(phaseprofiler::draw);
+        TRACE_SCOPE("osgViewer::renderingTraversals");
+        mViewer->renderingTraversals();
+    }
+    if(phaseprofiler::enabled)
+        publish_phase_times();
+}
+
+// Closes the profiler frame and hands its phase times to the stats
+// overlay, which shows them under OSG's own lines.
+void OSGWidget::publish_phase_times()
+{
+    phaseprofiler::end_frame();
+    phaseprofiler::FrameTimes frameTimes{phaseprofiler::get_last_frame()};
+    osg::Stats *stats = mViewer->getViewerStats();
+    unsigned int frameNumber{mViewer->getViewerFrameStamp()->getFrameNumber()};
+    for(unsigned int phase{0}; phase < phaseprofiler::phaseCount; phase++)
+        stats->setAttribute(frameNumber, std::string(phaseprofiler::get_phase_name(phaseprofiler::Phase(phase))) + " time taken", frameTimes.milliseconds[phase]/1000.0);
 }
 
 void OSGWidget::resizeGL(int width, int height)
@@ -186,7 +235,13 @@ void OSGWidget::create_view()
 {
     mView->setCamera(camera);
     mView->setSceneData(this->mRoot.get());
-    mView->addEventHandler(new osgViewer::StatsHandler);
+    statsHandler = new osgViewer::StatsHandler;
+    for(unsigned int phase{0}; phaseprofiler::enabled && phase < phaseprofiler::phaseCount; phase++)
+    {
+        std::string phaseName{phaseprofiler::get_phase_name(phaseprofiler::Phase(phase))};
+        statsHandler->addUserStatsLine(phaseName, osg::Vec4(1.f, 1.f, 1.f, 1.f), osg::Vec4(1.f, 0.6f, 0.2f, 1.f), phaseName + " time taken", 1000.0, true, false, "", "", 0.0);
+    }
+    mView->addEventHandler(statsHandler);
     mView->setCameraManipulator(manipulator);
 }
 
@@ -208,6 +263,7 @@ void OSGWidget::add_cylinder()
     osg::ShapeDrawable* sdCylinder = new osg::ShapeDrawable(cylinder);
     sdCylinder->setColor(cylinderColor);
     sdCylinder->setName("Cylinder");
+    nozzleDrawable = sdCylinder;
     osg::Geode* geodeCylinder = new osg::Geode;
     geodeCylinder->addDrawable(sdCylinder);
     osg::StateSet* stateSetCylinder = geodeCylinder->getOrCreateStateSet();
@@ -260,64 +316,100 @@ void OSGWidget::configure_update()
 
     double simulationUpdateTimeStep{1.0/this->framesPerSecond};
     double simulationTimerDurationInMilliSeconds{simulationUpdateTimeStep * 1000};
-    this->simulationUpdateTimerId = startTimer(simulationTimerDurationInMilliSeconds);
-
-    double ballUpdateTimeStep{1.0/this->ballsPerSecond};
-    double ballTimerDurationInMilliSeconds{ballUpdateTimeStep * 1000};
-    this->ballUpdateTimerId = startTimer(ballTimerDurationInMilliSeconds);
+    this->simulationUpdateTimerId = startTimer(simulationTimerDurationInMilliSeconds, Qt::PreciseTimer);
 }
 
-void OSGWidget::add_ball()
+void OSGWidget::add_ball_spheres()
 {
-    Eigen::Vector3f noisyVelocity{osgwidgetutils::get_small_random_float(), osgwidgetutils::get_small_random_float(), physics.get_new_ball_velocity()[2]};
-    this->physics.set_new_ball_velocity(noisyVelocity);
-    physics.add_ball();
+    ballGeode = instancedsphere::create_instanced_sphere_geode();
+    osg::Geometry* sphereGeometry = ballGeode->getDrawable(0)->asGeometry();
+    sphereUpdateCallback = new SphereUpdateCallback(physics.get_snapshot_buffer(), &simulationClock, sphereGeometry);
+    sphereUpdateCallback->reserve(physics.get_max_ball_count());
+    ballGeode->setUpdateCallback(sphereUpdateCallback.get());
+    this->mRoot->addChild(ballGeode);
+}
 
-    if(physics.get_ball_count() < physics.get_max_ball_count())
-    {
-        osg::Vec3 initialBallPosition{0.f, 0.f, 3*physics.get_new_ball_radius()};
-        osg::Vec4 initialBallColor{osgwidgetutils::hue_to_osg_rgba_decimal(physics.get_new_ball_color())};
-        osg::Sphere* ball = new osg::Sphere(osg::Vec3{0.f, 0.f, 0.f}, physics.get_new_ball_radius());
-        osg::ShapeDrawable* sdBall = new osg::ShapeDrawable(ball);
-        sdBall->setColor(initialBallColor);
-        sdBall->setName("Sphere");
-        osg::Geode* geodeBall = new osg::Geode;
-        geodeBall->addDrawable(sdBall);
-        osg::StateSet* stateSetBall = geodeBall->getOrCreateStateSet();
-        osg::Material* materialBall = new osg::Material;
-        materialBall->setColorMode(osg::Material::AMBIENT_AND_DIFFUSE);
-        stateSetBall->setAttributeAndModes(materialBall, osg::StateAttribute::ON);
-        stateSetBall->setMode(GL_DEPTH_TEST, osg::StateAttribute::ON);
-        osg::PositionAttitudeTransform *transformBall = new osg::PositionAttitudeTransform;
-        transformBall->setPosition(initialBallPosition);
-        transformBall->setUpdateCallback(new SphereUpdateCallback(&physics));
-        transformBall->addChild(geodeBall);
-        this->mRoot->addChild(transformBall);
-    }
+void OSGWidget::update_nozzle_emitter()
+{
+    Emitter *nozzleEmitter = physics.get_emitter_ptr(nozzleEmitterIndex);
+    Eigen::Vector3f launchVelocity{physics.get_new_ball_velocity()};
+    nozzleEmitter->set_position(physics.get_new_ball_position());
+    nozzleEmitter->set_direction(launchVelocity);
+    nozzleEmitter->set_speed(launchVelocity.norm());
+    nozzleEmitter->set_spread_angle(nozzleSpreadAngle);
+    nozzleEmitter->set_balls_per_second(ballsPerSecond);
+    nozzleEmitter->set_radius_range(physics.get_new_ball_radius(), physics.get_new_ball_radius());
+    nozzleEmitter->set_mass_range(physics.get_new_ball_mass(), physics.get_new_ball_mass());
+    nozzleEmitter->set_color_range(physics.get_new_ball_color(), physics.get_new_ball_color());
+    nozzleEmitter->set_coefficient_of_restitution_range(physics.get_new_ball_coefficient_of_restitution(), physics.get_new_ball_coefficient_of_restitution());
 }
 
 void OSGWidget::clear_balls()
 {
-    mRoot->removeChildren(2, physics.get_ball_count());
+    TRACE_SCOPE("OSGWidget::clear_balls");
     physics.clear_balls();
+    historyNeedsKeyframe = true;
+    physics.publish_snapshot();
+    update();
+}
+
+bool OSGWidget::save_scene(const std::string &path)
+{
+    return physics.save_scene(path);
+}
+
+// A scene saved without emitters gets the nozzle back so the sliders keep
+// working on it. Otherwise the first emitter becomes the nozzle as loaded,
+// and the slider settings are read back from it. The scene may raise the
+// ball limit, so the instance arrays are reserved again.
+bool OSGWidget::load_scene(const std::string &path)
+{
+    if(!physics.load_scene(path))
+        return false;
+    nozzleEmitterIndex = 0;
+    if(physics.get_emitter_count() == 0)
+    {
+        physics.add_emitter(Emitter());
+        update_nozzle_emitter();
+    }
+    Emitter *nozzleEmitter = physics.get_emitter_ptr(nozzleEmitterIndex);
+    ballsPerSecond = nozzleEmitter->get_balls_per_second();
+    nozzleSpreadAngle = nozzleEmitter->get_spread_angle();
+    update_nozzle();
+    sphereUpdateCallback->reserve(physics.get_max_ball_count());
+    history.clear();
+    historyNeedsKeyframe = true;
+    physics.publish_snapshot();
+    simulationClock.reset();
     update();
+    return true;
 }
 
-void OSGWidget::update_ball_update_rate()
+// Puts the simulator back to a recorded step, parameters included. Running
+// on from there replaces whatever had been recorded after it.
+bool OSGWidget::seek_step(unsigned long step)
 {
-    killTimer(ballUpdateTimerId);
-    double ballUpdateTimeStep{1.0/ballsPerSecond};
-    double ballTimerDurationInMilliSeconds{ballUpdateTimeStep * 1000};
-    ballUpdateTimerId = startTimer(ballTimerDurationInMilliSeconds);
+    if(historyNeedsKeyframe && !history.is_empty() && physics.get_step_count() >= history.get_last_step())
+    {
+        history.capture(physics, simulationClock.get_fixed_time_step());
+        historyNeedsKeyframe = false;
+    }
+    if(!history.seek(physics, step))
+        return false;
+    historyNeedsKeyframe = false;
+    ballsPerSecond = physics.get_emitter_ptr(nozzleEmitterIndex)->get_balls_per_second();
+    update_nozzle();
+    sphereUpdateCallback->reserve(physics.get_max_ball_count());
+    physics.publish_snapshot();
+    simulationClock.reset();
+    update();
+    return true;
 }
 
 void OSGWidget::update_nozzle()
 {
-    osg::PositionAttitudeTransform *nozzleTransform = dynamic_cast<osg::PositionAttitudeTransform *> (this->mRoot->getChild(0));
-    osg::Geode *nozzleGeode = nozzleTransform->getChild(0)->asGeode();
-    osg::ShapeDrawable *nozzleShapeDrawable = dynamic_cast<osg::ShapeDrawable *> (nozzleGeode->getDrawable(0));
     osg::Cylinder *nozzle = new osg::Cylinder(osg::Vec3(0.f, 0.f, 0.f), physics.get_new_ball_radius(), physics.get_new_ball_radius()*fountainHeightScale);
-    nozzleShapeDrawable->setShape(nozzle);
+    nozzleDrawable->setShape(nozzle);
 }
 
 BallPhysics* OSGWidget::get_physics_ptr()
@@ -325,6 +417,11 @@ BallPhysics* OSGWidget::get_physics_ptr()
     return &(this->physics);
 }
 
+SimulationHistory* OSGWidget::get_history_ptr()
+{
+    return &(this->history);
+}
+
 float OSGWidget::get_ground_plane_size()
 {
     return this->initialGroundPlaneSize;
@@ -378,47 +475,62 @@ bool OSGWidget::is_paused()
 void OSGWidget::set_fluid_density(float newDensity)
 {
     this->get_physics_ptr()->set_fluid_density(newDensity/10.0);
+    historyNeedsKeyframe = true;
 }
 
 void OSGWidget::set_gravity(float newGravity)
 {
     this->get_physics_ptr()->set_gravity(newGravity);
+    historyNeedsKeyframe = true;
 }
 
 void OSGWidget::set_radius(float newRadius)
 {
     this->physics.set_new_ball_radius(newRadius);
     this->physics.set_new_ball_position(Eigen::Vector3f(0.0, 0.0, fountainHeightScale*physics.get_new_ball_radius()));
+    update_nozzle_emitter();
+    historyNeedsKeyframe = true;
 }
 
 void OSGWidget::set_mass(float newMass)
 {
     this->physics.set_new_ball_mass(newMass);
+    update_nozzle_emitter();
+    historyNeedsKeyframe = true;
 }
 
 void OSGWidget::set_color(unsigned int newColor)
 {
     this->physics.set_new_ball_color(newColor);
+    update_nozzle_emitter();
+    historyNeedsKeyframe = true;
 }
 
 void OSGWidget::set_velocity(float newUpwardVelocity)
 {
-    Eigen::Vector3f newVelocity{osgwidgetutils::get_small_random_float(), osgwidgetutils::get_small_random_float(), newUpwardVelocity};
+    Eigen::Vector3f newVelocity{0.0, 0.0, newUpwardVelocity};
     this->physics.set_new_ball_velocity(newVelocity);
+    update_nozzle_emitter();
+    historyNeedsKeyframe = true;
 }
 
 void OSGWidget::set_coefficient_of_restitution(float newCoefficient)
 {
     this->physics.set_new_ball_coefficient_of_restitution(newCoefficient);
+    update_nozzle_emitter();
+    historyNeedsKeyframe = true;
 }
 
 void OSGWidget::set_ball_rate(float newRate)
 {
     this->ballsPerSecond = newRate;
+    update_nozzle_emitter();
+    historyNeedsKeyframe = true;
 }
 
 void OSGWidget::set_pause_flag(bool pauseState)
 {
     this->pauseFlag = pauseState;
+    simulationClock.reset();
 }
 
@@ -1,10 +1,15 @@
 #ifndef OSG_WIDGET_HPP
 #define OSG_WIDGET_HPP
 
+#include "BallPhysics.hpp"
 #include "SphereUpdateCallback.hpp"
 #include "OSGWidgetUtils.hpp"
+#include "SimulationClock.hpp"
+#include "SimulationHistory.hpp"
+#include "InstancedSphereGeometry.hpp"
 
 #include <cassert>
+#include <thread>
 
 #include <QKeyEvent>
 #include <QPainter>
@@ -28,7 +33,9 @@
 #include <osgViewer/View>
 #include <osgViewer/ViewerEventHandlers>
 #include <osg/MatrixTransform>
+#include <osg/PositionAttitudeTransform>
 #include <osg/LineWidth>
+#include <osg/Stats>
 
 class OSGWidget : public QOpenGLWidget
 {
@@ -40,12 +47,14 @@ public:
 
     virtual ~OSGWidget();
 
-    void add_ball();
     void clear_balls();
-    void update_ball_update_rate();
     void update_nozzle();
+    bool save_scene(const std::string &path);
+    bool load_scene(const std::string &path);
+    bool seek_step(unsigned long step);
 
     BallPhysics* get_physics_ptr();
+    SimulationHistory* get_history_ptr();
 
     float get_ground_plane_size();
     float get_fluid_density();
@@ -89,7 +98,10 @@ protected:
     void create_viewer();
     void add_cylinder();
     void add_ground_plane();
+    void add_ball_spheres();
+    void update_nozzle_emitter();
     void configure_update();
+    void publish_phase_times();
 
     float initialGroundPlaneSize{10};
     float initialFluidDensity{0.5};
@@ -97,20 +109,32 @@ protected:
     float fountainHeightScale{3.0};
 
     float ballsPerSecond{5.0};
+    unsigned int nozzleEmitterIndex{0};
+    float nozzleSpreadAngle{0.001};
     bool pauseFlag{true};
 
+    SimulationHistory history;
+    bool historyNeedsKeyframe{true};
+
 private:
     virtual void on_resize( int width, int height );
     osgGA::EventQueue* getEventQueue() const;
 
     int simulationUpdateTimerId{0};
-    int ballUpdateTimerId{0};
     double framesPerSecond{30};
+    double physicsStepsPerSecond{120};
+    unsigned int maxPhysicsStepsPerFrame{16};
+    SimulationClock simulationClock{SimulationClock(1.0/physicsStepsPerSecond, maxPhysicsStepsPerFrame)};
 
     osg::ref_ptr<osgViewer::GraphicsWindowEmbedded> mGraphicsWindow;
     osg::ref_ptr<osgViewer::CompositeViewer> mViewer;
+    osg::ref_ptr<osgViewer::StatsHandler> statsHandler;
+    bool viewerStarted{false};
     osg::ref_ptr<osgViewer::View> mView;
     osg::ref_ptr<osg::Group> mRoot;
+    osg::ref_ptr<osg::ShapeDrawable> nozzleDrawable;
+    osg::ref_ptr<osg::Geode> ballGeode;
+    osg::ref_ptr<SphereUpdateCallback> sphereUpdateCallback;
     osg::Camera* camera;
     osg::ref_ptr<osgGA::TrackballManipulator> manipulator;
 };
@@ -0,0 +1,147 @@
+#include "PhaseProfiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+
+namespace phaseprofiler
+{
+namespace
+{
+const char *phaseNames[phaseCount]
+{
+    "integration", "box_collisions", "ball_collisions", "sleeping", "emission", "update_traversal", "draw"
+};
+
+struct alignas(64) ThreadCounters
+{
+    std::atomic<std::uint64_t> nanoseconds[phaseCount];
+    std::atomic<std::uint64_t> calls[phaseCount];
+};
+
+// Zero-initialized statics, so the counters exist before any thread asks.
+ThreadCounters threadCounters[maxThreadCount];
+std::atomic<unsigned int> threadsSeen{0};
+thread_local int threadSlot{-1};
+
+std::uint64_t previousNanoseconds[phaseCount];
+std::uint64_t previousCalls[phaseCount];
+FrameTimes frameHistory[frameHistorySize];
+unsigned int frameCount{0};
+std::uint64_t nextFrame{0};
+
+// Threads past the last slot share it; fetch_add keeps that correct.
+ThreadCounters& get_thread_counters()
+{
+    if(threadSlot < 0)
+    {
+        unsigned int slot{threadsSeen.fetch_add(1, std::memory_order_relaxed)};
+        threadSlot = slot < maxThreadCount ? slot : maxThreadCount - 1;
+    }
+    return threadCounters[threadSlot];
+}
+}
+
+ScopedTimer::ScopedTimer(Phase phaseInput)
+    : phase{phaseInput}, startTime{get_time()}
+{
+}
+
+ScopedTimer::~ScopedTimer()
+{
+    add_time(phase, get_time() - startTime);
+}
+
+const char* get_phase_name(Phase phase)
+{
+    return phase < phaseCount ? phaseNames[phase] : "unknown";
+}
+
+std::uint64_t get_time()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void add_time(Phase phase, std::uint64_t nanoseconds)
+{
+    ThreadCounters &counters = get_thread_counters();
+    counters.nanoseconds[phase].fetch_add(nanoseconds, std::memory_order_relaxed);
+    counters.calls[phase].fetch_add(1, std::memory_order_relaxed);
+}
+
+void end_frame()
+{
+    unsigned int threadCount{std::min(threadsSeen.load(std::memory_order_relaxed), maxThreadCount)};
+    FrameTimes &frameTimes = frameHistory[nextFrame % frameHistorySize];
+    frameTimes.frame = nextFrame++;
+    for(unsigned int phase{0}; phase < phaseCount; phase++)
+    {
+        std::uint64_t nanoseconds{0}, calls{0};
+        for(unsigned int thread{0}; thread < threadCount; thread++)
+        {
+            nanoseconds += threadCounters[thread].nanoseconds[phase].load(std::memory_order_relaxed);
+            calls += threadCounters[thread].calls[phase].load(std::memory_order_relaxed);
+        }
+        frameTimes.milliseconds[phase] = (nanoseconds - previousNanoseconds[phase])*1e-6;
+        frameTimes.calls[phase] = calls - previousCalls[phase];
+        previousNanoseconds[phase] = nanoseconds;
+        previousCalls[phase] = calls;
+    }
+    frameCount = std::min(frameCount + 1, frameHistorySize);
+}
+
+FrameTimes get_last_frame()
+{
+    if(frameCount == 0)
+        return FrameTimes{};
+    return frameHistory[(nextFrame - 1) % frameHistorySize];
+}
+
+unsigned int get_frame_count()
+{
+    return frameCount;
+}
+
+std::string format_frame(const FrameTimes &frameTimes)
+{
+    std::string text;
+    char field[64];
+    for(unsigned int phase{0}; phase < phaseCount; phase++)
+    {
+        std::snprintf(field, sizeof(field), "%s%s %.2f ms", phase > 0 ? "  " : "", phaseNames[phase], frameTimes.milliseconds[phase]);
+        text += field;
+    }
+    return text;
+}
+
+// One row per kept frame, oldest first, with the time and call count of
+// every phase.
+bool write_csv(const std::string &path)
+{
+    std::FILE *file{std::fopen(path.c_str(), "w")};
+    if(!file)
+        return false;
+    std::fprintf(file, "frame");
+    for(unsigned int phase{0}; phase < phaseCount; phase++)
+        std::fprintf(file, ",%s_ms,%s_calls", phaseNames[phase], phaseNames[phase]);
+    std::fprintf(file, "\n");
+    for(std::uint64_t frame{nextFrame - frameCount}; frame < nextFrame; frame++)
+    {
+        const FrameTimes &frameTimes = frameHistory[frame % frameHistorySize];
+        std::fprintf(file, "%llu", static_cast<unsigned long long>(frameTimes.frame));
+        for(unsigned int phase{0}; phase < phaseCount; phase++)
+            std::fprintf(file, ",%.4f,%llu", frameTimes.milliseconds[phase], static_cast<unsigned long long>(frameTimes.calls[phase]));
+        std::fprintf(file, "\n");
+    }
+    return std::fclose(file) == 0;
+}
+
+// Forgets the kept frames and starts the next one from the current totals.
+void reset()
+{
+    end_frame();
+    frameCount = 0;
+    nextFrame = 0;
+}
+}
@@ -0,0 +1,77 @@
+#ifndef PHASE_PROFILER_HPP
+#define PHASE_PROFILER_HPP
+
+#include <cstdint>
+#include <string>
+
+// Wall time spent in each phase of a frame. Timers add into counters owned
+// by the calling thread, so worker threads never contend; end_frame() sums
+// the threads and keeps the difference as that frame's row. Phases that run
+// on several threads at once therefore report thread time, not wall time.
+//
+// The PROFILE_PHASE macro only expands to a timer when the build defines
+// PHYSICS_PROFILING, so with it off the hot paths carry no trace of it.
+namespace phaseprofiler
+{
+enum Phase
+{
+    integration,
+    boxCollisions,
+    ballCollisions,
+    sleeping,
+    emission,
+    updateTraversal,
+    draw,
+    phaseCount
+};
+
+#ifdef PHYSICS_PROFILING
+const bool enabled{true};
+#else
+const bool enabled{false};
+#endif
+const unsigned int maxThreadCount{64};
+const unsigned int frameHistorySize{4096};
+
+struct FrameTimes
+{
+    std::uint64_t frame;
+    double milliseconds[phaseCount];
+    std::uint64_t calls[phaseCount];
+};
+
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Phase phaseInput);
+    ~ScopedTimer();
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer& operator=(const ScopedTimer &) = delete;
+
+private:
+    Phase phase;
+    std::uint64_t startTime;
+};
+
+const char* get_phase_name(Phase phase);
+std::uint64_t get_time();
+void add_time(Phase phase, std::uint64_t nanoseconds);
+
+// The functions below are for the thread that drives frames only.
+void end_frame();
+FrameTimes get_last_frame();
+unsigned int get_frame_count();
+std::string format_frame(const FrameTimes &frameTimes);
+bool write_csv(const std::string &path);
+void reset();
+}
+
+#ifdef PHYSICS_PROFILING
+#define PROFILE_PHASE_NAME(line) phaseTimer##line
+#define PROFILE_PHASE_LINE(phase, line) phaseprofiler::ScopedTimer PROFILE_PHASE_NAME(line)(phase)
+#define PROFILE_PHASE(phase) PROFILE_PHASE_LINE(phase, __LINE__)
+#else
+#define PROFILE_PHASE(phase) do {} while(0)
+#endif
+
+#endif
@@ -0,0 +1,114 @@
+#include "gtest/gtest.h"
+#include "PhaseProfiler.hpp"
+#include "BallPhysics.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+
+class PhaseProfilerTests : public ::testing::Test
+{
+protected:
+    void SetUp();
+};
+
+void PhaseProfilerTests::SetUp()
+{
+    phaseprofiler::reset();
+}
+
+TEST_F(PhaseProfilerTests, WhenTimerGoesOutOfScope_ExpectTimeAndCallInFrame)
+{
+    {
+        phaseprofiler::ScopedTimer timer(phaseprofiler::draw);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    phaseprofiler::end_frame();
+
+    phaseprofiler::FrameTimes frameTimes{phaseprofiler::get_last_frame()};
+    EXPECT_GE(frameTimes.milliseconds[phaseprofiler::draw], 2);
+    EXPECT_EQ(frameTimes.calls[phaseprofiler::draw], 1);
+    EXPECT_EQ(frameTimes.calls[phaseprofiler::integration], 0);
+}
+
+TEST_F(PhaseProfilerTests, WhenEndingFrames_ExpectEachFrameOnlyItsOwnTime)
+{
+    phaseprofiler::add_time(phaseprofiler::emission, 3000000);
+    phaseprofiler::end_frame();
+    phaseprofiler::add_time(phaseprofiler::emission, 1000000);
+    phaseprofiler::end_frame();
+
+    phaseprofiler::FrameTimes frameTimes{phaseprofiler::get_last_frame()};
+    EXPECT_EQ(frameTimes.frame, 1);
+    EXPECT_DOUBLE_EQ(frameTimes.milliseconds[phaseprofiler::emission], 1);
+    EXPECT_EQ(phaseprofiler::get_frame_count(), 2);
+}
+
+TEST_F(PhaseProfilerTests, WhenSeveralThreadsTime_ExpectTheirTimesSummed)
+{
+    std::vector<std::thread> threads;
+    for(int thread{0}; thread < 4; thread++)
+        threads.emplace_back([]
+        {
+            for(int call{0}; call < 1000; call++)
+                phaseprofiler::add_time(phaseprofiler::ballCollisions, 1000);
+        });
+    for(std::thread &thread : threads)
+        thread.join();
+    phaseprofiler::end_frame();
+
+    phaseprofiler::FrameTimes frameTimes{phaseprofiler::get_last_frame()};
+    EXPECT_EQ(frameTimes.calls[phaseprofiler::ballCollisions], 4000);
+    EXPECT_DOUBLE_EQ(frameTimes.milliseconds[phaseprofiler::ballCollisions], 4);
+}
+
+TEST_F(PhaseProfilerTests, WhenSteppingPhysics_ExpectPhasesTimedOnlyWhenCompiledIn)
+{
+    BallPhysics fountain(10, 1.2, -9.81, 200);
+    fountain.add_emitter(Emitter(Eigen::Vector3f{0, 0, 0.5}, Eigen::Vector3f{0, 0, 1}, 15, 400));
+    for(int step{0}; step < 10; step++)
+        fountain.update(1.0/120);
+    phaseprofiler::end_frame();
+
+    phaseprofiler::FrameTimes frameTimes{phaseprofiler::get_last_frame()};
+    unsigned long expectedCalls{phaseprofiler::enabled ? 10ul : 0ul};
+    EXPECT_EQ(frameTimes.calls[phaseprofiler::ballCollisions], expectedCalls);
+    EXPECT_EQ(frameTimes.calls[phaseprofiler::emission], expectedCalls);
+    EXPECT_EQ(frameTimes.calls[phaseprofiler::draw], 0);
+}
+
+TEST_F(PhaseProfilerTests, WhenWritingCsv_ExpectHeaderAndOneRowPerFrame)
+{
+    std::string path{::testing::TempDir() + "PhaseProfilerTests.csv"};
+    for(int frame{0}; frame < 3; frame++)
+    {
+        phaseprofiler::add_time(phaseprofiler::integration, 500000);
+        phaseprofiler::end_frame();
+    }
+
+    ASSERT_TRUE(phaseprofiler::write_csv(path));
+
+    std::ifstream file(path);
+    std::vector<std::string> lines;
+    for(std::string line; std::getline(file, line);)
+        lines.push_back(line);
+    std::remove(path.c_str());
+    ASSERT_EQ(lines.size(), 4);
+    EXPECT_EQ(lines[0].compare(0, 35, "frame,integration_ms,integration_ca"), 0);
+    EXPECT_EQ(lines[1].compare(0, 15, "0,0.5000,1,0.00"), 0);
+    EXPECT_EQ(lines[3][0], '2');
+}
+
+TEST_F(PhaseProfilerTests, WhenFormattingFrame_ExpectEveryPhaseNamed)
+{
+    phaseprofiler::add_time(phaseprofiler::sleeping, 1250000);
+    phaseprofiler::end_frame();
+
+    std::string text{phaseprofiler::format_frame(phaseprofiler::get_last_frame())};
+
+    for(unsigned int phase{0}; phase < phaseprofiler::phaseCount; phase++)
+        EXPECT_NE(text.find(phaseprofiler::get_phase_name(phaseprofiler::Phase(phase))), std::string::npos);
+    EXPECT_NE(text.find("sleeping 1.25 ms"), std::string::npos);
+}
@@ -0,0 +1,252 @@
+#include "SceneFile.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+
+namespace scenefile
+{
+namespace
+{
+const std::uint64_t arrayAlignment{64};
+
+AlignedVector<float> BallStorage::* const floatArrays[floatArrayCount]
+{
+    &BallStorage::positionX, &BallStorage::positionY, &BallStorage::positionZ,
+    &BallStorage::previousPositionX, &BallStorage::previousPositionY, &BallStorage::previousPositionZ,
+    &BallStorage::velocityX, &BallStorage::velocityY, &BallStorage::velocityZ,
+    &BallStorage::accelerationX, &BallStorage::accelerationY, &BallStorage::accelerationZ,
+    &BallStorage::radius, &BallStorage::mass, &BallStorage::inverseMass,
+    &BallStorage::dragConstant, &BallStorage::coefficientOfRestitution, &BallStorage::sleepTime
+};
+
+AlignedVector<unsigned int> BallStorage::* const integerArrays[integerArrayCount]
+{
+    &BallStorage::color, &BallStorage::revision
+};
+
+std::uint64_t align_offset(std::uint64_t offset)
+{
+    return (offset + arrayAlignment - 1)/arrayAlignment*arrayAlignment;
+}
+
+// Keeps handing the remaining iovecs to writev until everything is out.
+bool write_all(int fileDescriptor, std::vector<iovec> &blocks)
+{
+    unsigned int firstBlock{0};
+    while(firstBlock < blocks.size())
+    {
+        int blockCount{int(std::min<std::size_t>(blocks.size() - firstBlock, IOV_MAX))};
+        ssize_t written{writev(fileDescriptor, &blocks[firstBlock], blockCount)};
+        if(written < 0 && errno == EINTR)
+            continue;
+        if(written <= 0)
+            return false;
+        while(firstBlock < blocks.size() && std::size_t(written) >= blocks[firstBlock].iov_len)
+            written -= blocks[firstBlock++].iov_len;
+        if(firstBlock < blocks.size())
+        {
+            blocks[firstBlock].iov_base = static_cast<char *>(blocks[firstBlock].iov_base) + written;
+            blocks[firstBlock].iov_len -= written;
+        }
+    }
+    return true;
+}
+}
+
+EmitterRecord make_emitter_record(Emitter &emitter)
+{
+    EmitterRecord record;
+    std::memset(&record, 0, sizeof(record));
+    for(int axis{0}; axis < 3; axis++)
+    {
+        record.position[axis] = emitter.get_position()[axis];
+        record.direction[axis] = emitter.get_direction()[axis];
+    }
+    record.speed = emitter.get_speed();
+    record.spreadAngle = emitter.get_spread_angle();
+    record.ballsPerSecond = emitter.get_balls_per_second();
+    record.minRadius = emitter.get_min_radius();
+    record.maxRadius = emitter.get_max_radius();
+    record.minMass = emitter.get_min_mass();
+    record.maxMass = emitter.get_max_mass();
+    record.minColor = emitter.get_min_color();
+    record.maxColor = emitter.get_max_color();
+    record.minCoefficientOfRestitution = emitter.get_min_coefficient_of_restitution();
+    record.maxCoefficientOfRestitution = emitter.get_max_coefficient_of_restitution();
+    record.emissionAccumulator = emitter.get_emission_accumulator();
+    record.generatorState = emitter.get_generator_state();
+    return record;
+}
+
+// Fails on a generator state the emitter cannot take, so a damaged record
+// never resumes from a default seed.
+bool make_emitter(const EmitterRecord &record, Emitter &emitter)
+{
+    emitter = Emitter(Eigen::Vector3f{record.position[0], record.position[1], record.position[2]}, Eigen::Vector3f{record.direction[0], record.direction[1], record.direction[2]}, record.speed, record.ballsPerSecond);
+    emitter.set_spread_angle(record.spreadAngle);
+    emitter.set_radius_range(record.minRadius, record.maxRadius);
+    emitter.set_mass_range(record.minMass, record.maxMass);
+    emitter.set_color_range(record.minColor, record.maxColor);
+    emitter.set_coefficient_of_restitution_range(record.minCoefficientOfRestitution, record.maxCoefficientOfRestitution);
+    emitter.set_emission_accumulator(record.emissionAccumulator);
+    return emitter.set_generator_state(record.generatorState);
+}
+
+// The file is gathered straight from the ball arrays into one writev, so
+// nothing is copied, and written beside the target and renamed over it so a
+// failed save never leaves a truncated scene behind.
+bool write(const std::string &path, Header header, const std::vector<EmitterRecord> &emitters, const BallStorage &balls, const std::vector<unsigned int> &spawnOrder)
+{
+    static const char padding[arrayAlignment]{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = currentVersion;
+    header.byteOrderMark = byteOrderMark;
+    header.headerSize = sizeof(Header);
+    header.emitterRecordSize = sizeof(EmitterRecord);
+    header.emitterCount = emitters.size();
+
+    std::vector<iovec> blocks;
+    blocks.reserve(2 + 2*arrayCount);
+    blocks.push_back(iovec{&header, sizeof(Header)});
+    if(!emitters.empty())
+        blocks.push_back(iovec{const_cast<EmitterRecord *>(emitters.data()), emitters.size()*sizeof(EmitterRecord)});
+
+    std::uint64_t arrayBytes{std::uint64_t(header.ballCount)*sizeof(float)};
+    std::uint64_t offset{sizeof(Header) + emitters.size()*sizeof(EmitterRecord)};
+    for(unsigned int arrayIndex{0}; arrayIndex < arrayCount; arrayIndex++)
+    {
+        const void *data{nullptr};
+        if(arrayIndex < floatArrayCount)
+            data = (balls.*floatArrays[arrayIndex]).data();
+        else if(arrayIndex < floatArrayCount + integerArrayCount)
+            data = (balls.*integerArrays[arrayIndex - floatArrayCount]).data();
+        else
+            data = spawnOrder.data();
+
+        std::uint64_t alignedOffset{align_offset(offset)};
+        if(alignedOffset > offset)
+            blocks.push_back(iovec{const_cast<char *>(padding), std::size_t(alignedOffset - offset)});
+        header.arrayOffsets[arrayIndex] = alignedOffset;
+        if(arrayBytes > 0)
+            blocks.push_back(iovec{const_cast<void *>(data), std::size_t(arrayBytes)});
+        offset = alignedOffset + arrayBytes;
+    }
+    header.fileSize = offset;
+
+    std::string temporaryPath{path + ".tmp"};
+    int fileDescriptor{::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)};
+    if(fileDescriptor < 0)
+        return false;
+    bool written{write_all(fileDescriptor, blocks)};
+    written = ::close(fileDescriptor) == 0 && written;
+    if(!written || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string &path)
+{
+    close();
+    int fileDescriptor{::open(path.c_str(), O_RDONLY)};
+    if(fileDescriptor < 0)
+        return false;
+    struct stat fileStatus;
+    if(fstat(fileDescriptor, &fileStatus) != 0 || std::uint64_t(fileStatus.st_size) < sizeof(Header))
+    {
+        ::close(fileDescriptor);
+        return false;
+    }
+    mappingSize = fileStatus.st_size;
+    int mappingFlags{MAP_PRIVATE};
+#ifdef MAP_POPULATE
+    mappingFlags |= MAP_POPULATE;
+#endif
+    mapping = mmap(nullptr, mappingSize, PROT_READ, mappingFlags, fileDescriptor, 0);
+    ::close(fileDescriptor);
+    if(mapping == MAP_FAILED)
+    {
+        mapping = nullptr;
+        mappingSize = 0;
+        return false;
+    }
+
+    const Header &header = get_header();
+    bool valid{std::memcmp(header.magic, magic, sizeof(magic)) == 0 && header.version == currentVersion && header.byteOrderMark == byteOrderMark};
+    valid = valid && header.headerSize == sizeof(Header) && header.emitterRecordSize == sizeof(EmitterRecord);
+    valid = valid && header.fileSize == mappingSize && header.ballCount <= header.maxBallCount && header.maxBallCount <= maxBallCountLimit;
+    std::uint64_t arrayBytes{std::uint64_t(header.ballCount)*sizeof(float)};
+    std::uint64_t minimumOffset{sizeof(Header) + std::uint64_t(header.emitterCount)*sizeof(EmitterRecord)};
+    for(unsigned int arrayIndex{0}; valid && arrayIndex < arrayCount; arrayIndex++)
+    {
+        std::uint64_t offset{header.arrayOffsets[arrayIndex]};
+        valid = offset >= minimumOffset && offset % arrayAlignment == 0 && offset <= mappingSize && arrayBytes <= mappingSize - offset;
+        minimumOffset = offset + arrayBytes;
+    }
+    valid = valid && minimumOffset <= mappingSize;
+    if(!valid)
+        close();
+    return valid;
+}
+
+void MappedFile::close()
+{
+    if(mapping)
+        munmap(mapping, mappingSize);
+    mapping = nullptr;
+    mappingSize = 0;
+}
+
+const Header& MappedFile::get_header() const
+{
+    return *static_cast<const Header *>(mapping);
+}
+
+const EmitterRecord* MappedFile::get_emitters() const
+{
+    return reinterpret_cast<const EmitterRecord *>(static_cast<const char *>(mapping) + sizeof(Header));
+}
+
+const std::uint32_t* MappedFile::get_spawn_order() const
+{
+    return static_cast<const std::uint32_t *>(get_array(arrayCount - 1));
+}
+
+// One bulk copy per array out of the mapping; no per-ball parsing.
+void MappedFile::copy_balls_to(BallStorage &balls) const
+{
+    unsigned int ballCount{get_header().ballCount};
+    balls.clear();
+    balls.reserve(get_header().maxBallCount);
+    for(unsigned int arrayIndex{0}; arrayIndex < floatArrayCount; arrayIndex++)
+    {
+        const float *values{static_cast<const float *>(get_array(arrayIndex))};
+        (balls.*floatArrays[arrayIndex]).assign(values, values + ballCount);
+    }
+    for(unsigned int arrayIndex{0}; arrayIndex < integerArrayCount; arrayIndex++)
+    {
+        const unsigned int *values{static_cast<const unsigned int *>(get_array(floatArrayCount + arrayIndex))};
+        (balls.*integerArrays[arrayIndex]).assign(values, values + ballCount);
+    }
+}
+
+const void* MappedFile::get_array(unsigned int arrayIndex) const
+{
+    return static_cast<const char *>(mapping) + get_header().arrayOffsets[arrayIndex];
+}
+}
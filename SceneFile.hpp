@@ -0,0 +1,109 @@
+#ifndef SCENE_FILE_HPP
+#define SCENE_FILE_HPP
+
+#include "BallStorage.hpp"
+#include "Emitter.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A scene file is the header, the emitter records and then one 64-byte
+// aligned block per ball array, in the order of the tables in SceneFile.cpp,
+// followed by the spawn order. Every field is stored in host byte order; the
+// byte order mark rejects files from a host with the other one.
+namespace scenefile
+{
+const char magic[8]{'B', 'F', 'S', 'C', 'E', 'N', 'E', '\0'};
+const std::uint32_t currentVersion{2};
+const std::uint32_t byteOrderMark{0x01020304};
+const unsigned int floatArrayCount{18};
+const unsigned int integerArrayCount{2};
+const unsigned int arrayCount{floatArrayCount + integerArrayCount + 1};
+// Far above any scene the app runs, low enough that a corrupt count cannot
+// make loading reserve gigabytes.
+const std::uint32_t maxBallCountLimit{1u << 22};
+
+struct Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrderMark;
+    std::uint32_t headerSize;
+    std::uint32_t emitterRecordSize;
+    std::uint64_t fileSize;
+    std::uint64_t arrayOffsets[arrayCount];
+    std::uint64_t stepCount;
+
+    std::uint32_t ballCount;
+    std::uint32_t maxBallCount;
+    std::uint32_t emitterCount;
+    std::uint32_t revisionCounter;
+
+    float gravity;
+    float boxBoundSize;
+    float dragCoefficient;
+    float fluidDensity;
+    std::uint32_t sleepingEnabled;
+    float sleepVelocityThreshold;
+    float sleepTimeThreshold;
+
+    float newBallRadius;
+    float newBallMass;
+    std::uint32_t newBallColor;
+    float newBallPosition[3];
+    float newBallVelocity[3];
+    float newBallCoefficientOfRestitution;
+};
+
+struct EmitterRecord
+{
+    float position[3];
+    float direction[3];
+    float speed;
+    float spreadAngle;
+    float ballsPerSecond;
+    float minRadius;
+    float maxRadius;
+    float minMass;
+    float maxMass;
+    std::uint32_t minColor;
+    std::uint32_t maxColor;
+    float minCoefficientOfRestitution;
+    float maxCoefficientOfRestitution;
+    double emissionAccumulator;
+    GeneratorState generatorState;
+};
+
+EmitterRecord make_emitter_record(Emitter &emitter);
+bool make_emitter(const EmitterRecord &record, Emitter &emitter);
+
+bool write(const std::string &path, Header header, const std::vector<EmitterRecord> &emitters, const BallStorage &balls, const std::vector<unsigned int> &spawnOrder);
+
+// Maps a scene file read-only and checks that the header and every block
+// lie inside it before anything is handed out.
+class MappedFile
+{
+public:
+    MappedFile() {}
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile& operator=(const MappedFile &) = delete;
+
+    bool open(const std::string &path);
+    void close();
+
+    const Header& get_header() const;
+    const EmitterRecord* get_emitters() const;
+    const std::uint32_t* get_spawn_order() const;
+    void copy_balls_to(BallStorage &balls) const;
+
+protected:
+    const void* get_array(unsigned int arrayIndex) const;
+
+    void *mapping{nullptr};
+    std::size_t mappingSize{0};
+};
+}
+
+#endif
@@ -0,0 +1,221 @@
+#include "gtest/gtest.h"
+#include "UnitTestUtils.hpp"
+#include "BallPhysics.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+
+
+class SceneFileTests : public ::testing::Test
+{
+protected:
+    void SetUp();
+    void TearDown();
+    void fill_scene(BallPhysics &scene);
+    void EXPECT_SAME_BALLS(BallPhysics &loaded, BallPhysics &saved);
+
+    std::string path;
+    float stepTime{1.0/120};
+};
+
+void SceneFileTests::SetUp()
+{
+    path = ::testing::TempDir() + "SceneFileTests_" + ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".scene";
+}
+
+void SceneFileTests::TearDown()
+{
+    std::remove(path.c_str());
+}
+
+void SceneFileTests::fill_scene(BallPhysics &scene)
+{
+    scene.set_gravity(-5);
+    scene.set_drag_coefficient(0.3);
+    scene.set_new_ball_parameters(0.25, 2, 120, Eigen::Vector3f{1, 2, 3}, Eigen::Vector3f{0, 1, 12}, 0.6);
+    Emitter nozzle(Eigen::Vector3f{0, 0, 1}, Eigen::Vector3f{0, 0, 1}, 12, 90, 7);
+    nozzle.set_spread_angle(0.4);
+    nozzle.set_radius_range(0.2, 0.4);
+    nozzle.set_color_range(10, 200);
+    scene.add_emitter(nozzle);
+    for(int step{0}; step < 200; step++)
+        scene.update(stepTime);
+}
+
+void SceneFileTests::EXPECT_SAME_BALLS(BallPhysics &loaded, BallPhysics &saved)
+{
+    ASSERT_EQ(loaded.get_ball_count(), saved.get_ball_count());
+    for(unsigned int index{0}; index < saved.get_ball_count(); index++)
+    {
+        EXPECT_VECTOR3_FLOAT_EQ(loaded.get_ball_ptr(index)->position, saved.get_ball_ptr(index)->position);
+        EXPECT_VECTOR3_FLOAT_EQ(loaded.get_ball_ptr(index)->velocity, saved.get_ball_ptr(index)->velocity);
+        EXPECT_EQ(loaded.get_ball_ptr(index)->radius, saved.get_ball_ptr(index)->radius);
+        EXPECT_EQ(loaded.get_ball_ptr(index)->color, saved.get_ball_ptr(index)->color);
+        EXPECT_EQ(loaded.get_ball_revision(index), saved.get_ball_revision(index));
+    }
+}
+
+TEST_F(SceneFileTests, WhenSavingAndLoadingScene_ExpectSameBallsAndParameters)
+{
+    BallPhysics saved(20, 1.5, -9.81, 500);
+    fill_scene(saved);
+    ASSERT_TRUE(saved.save_scene(path));
+
+    BallPhysics loaded;
+    ASSERT_TRUE(loaded.load_scene(path));
+
+    EXPECT_SAME_BALLS(loaded, saved);
+    EXPECT_EQ(loaded.get_max_ball_count(), 500);
+    EXPECT_EQ(loaded.get_box_size(), 20);
+    EXPECT_EQ(loaded.get_fluid_density(), 1.5);
+    EXPECT_EQ(loaded.get_gravity(), -5);
+    EXPECT_FLOAT_EQ(loaded.get_drag_coefficient(), 0.3);
+    EXPECT_EQ(loaded.get_step_count(), saved.get_step_count());
+    EXPECT_EQ(loaded.get_new_ball_radius(), 0.25);
+    EXPECT_EQ(loaded.get_new_ball_color(), 120);
+    EXPECT_VECTOR3_FLOAT_EQ(loaded.get_new_ball_velocity(), Eigen::Vector3f(0, 1, 12));
+    ASSERT_EQ(loaded.get_emitter_count(), 1);
+    EXPECT_EQ(loaded.get_emitter_ptr(0)->get_balls_per_second(), 90);
+    EXPECT_FLOAT_EQ(loaded.get_emitter_ptr(0)->get_spread_angle(), 0.4);
+    EXPECT_EQ(loaded.get_emitter_ptr(0)->get_max_color(), 200);
+}
+
+TEST_F(SceneFileTests, WhenContinuingLoadedScene_ExpectSameTrajectoryAsOriginal)
+{
+    BallPhysics saved(20, 1.5, -9.81, 500);
+    fill_scene(saved);
+    ASSERT_TRUE(saved.save_scene(path));
+    BallPhysics loaded;
+    ASSERT_TRUE(loaded.load_scene(path));
+
+    for(int step{0}; step < 400; step++)
+    {
+        saved.update(stepTime);
+        loaded.update(stepTime);
+    }
+
+    EXPECT_SAME_BALLS(loaded, saved);
+}
+
+TEST_F(SceneFileTests, WhenLoadingScene_ExpectRecycleOrderKeptAndOldHandlesInvalidated)
+{
+    BallPhysics saved(20, 0, -9.81, 3);
+    for(int count{0}; count < 5; count++)
+        saved.add_ball();
+    ASSERT_TRUE(saved.save_scene(path));
+    BallPhysics loaded(20, 0, -9.81, 3);
+    BallHandle staleHandle{loaded.add_ball()};
+
+    ASSERT_TRUE(loaded.load_scene(path));
+
+    EXPECT_EQ(loaded.lookup(staleHandle), -1);
+    EXPECT_EQ(loaded.get_ball_replace_index(), saved.get_ball_replace_index());
+    EXPECT_EQ(loaded.get_ball_count(), 3);
+}
+
+TEST_F(SceneFileTests, WhenSavingEmptyScene_ExpectEmptySceneLoaded)
+{
+    BallPhysics saved;
+    ASSERT_TRUE(saved.save_scene(path));
+    BallPhysics loaded;
+    loaded.add_ball();
+
+    ASSERT_TRUE(loaded.load_scene(path));
+
+    EXPECT_EQ(loaded.get_ball_count(), 0);
+    EXPECT_EQ(loaded.get_emitter_count(), 0);
+}
+
+TEST_F(SceneFileTests, WhenLoadingMissingFile_ExpectFailureAndSceneUntouched)
+{
+    BallPhysics loaded;
+    loaded.add_ball();
+
+    EXPECT_FALSE(loaded.load_scene(path + ".missing"));
+    EXPECT_EQ(loaded.get_ball_count(), 1);
+}
+
+TEST_F(SceneFileTests, WhenLoadingFileWithWrongMagic_ExpectFailure)
+{
+    BallPhysics saved;
+    saved.add_ball();
+    ASSERT_TRUE(saved.save_scene(path));
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.write("NOTSCENE", 8);
+    file.close();
+
+    BallPhysics loaded;
+    EXPECT_FALSE(loaded.load_scene(path));
+}
+
+TEST_F(SceneFileTests, WhenLoadingTruncatedFile_ExpectFailure)
+{
+    BallPhysics saved;
+    for(int count{0}; count < 50; count++)
+        saved.add_ball();
+    ASSERT_TRUE(saved.save_scene(path));
+    std::ifstream input(path, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    input.close();
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output.write(contents.data(), contents.size() - 100);
+    output.close();
+
+    BallPhysics loaded;
+    EXPECT_FALSE(loaded.load_scene(path));
+}
+
+TEST_F(SceneFileTests, WhenLoadingFileWithHugeMaxBallCount_ExpectFailureAndSceneUntouched)
+{
+    BallPhysics saved;
+    saved.add_ball();
+    ASSERT_TRUE(saved.save_scene(path));
+    std::uint32_t hugeCount{0xFFFFFFFF};
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(offsetof(scenefile::Header, maxBallCount));
+    file.write(reinterpret_cast<const char *>(&hugeCount), sizeof(hugeCount));
+    file.close();
+
+    BallPhysics loaded;
+    loaded.add_ball();
+    loaded.add_ball();
+    EXPECT_FALSE(loaded.load_scene(path));
+    EXPECT_EQ(loaded.get_ball_count(), 2);
+}
+
+TEST_F(SceneFileTests, WhenLoadingFileWithCorruptGeneratorState_ExpectFailureAndSceneUntouched)
+{
+    BallPhysics saved;
+    fill_scene(saved);
+    ASSERT_TRUE(saved.save_scene(path));
+    GeneratorState zeroState{};
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(sizeof(scenefile::Header) + offsetof(scenefile::EmitterRecord, generatorState));
+    file.write(reinterpret_cast<const char *>(&zeroState), sizeof(zeroState));
+    file.close();
+
+    BallPhysics loaded;
+    loaded.add_ball();
+    EXPECT_FALSE(loaded.load_scene(path));
+    EXPECT_EQ(loaded.get_ball_count(), 1);
+    EXPECT_EQ(loaded.get_emitter_count(), 0);
+}
+
+TEST_F(SceneFileTests, WhenLoadingOverExistingBalls_ExpectRevisionsNeverReused)
+{
+    BallPhysics saved;
+    fill_scene(saved);
+    ASSERT_TRUE(saved.save_scene(path));
+    BallPhysics loaded;
+    for(int count{0}; count < 300; count++)
+        loaded.add_ball();
+    unsigned int usedRevision{0};
+    for(unsigned int index{0}; index < loaded.get_ball_count(); index++)
+        usedRevision = std::max(usedRevision, loaded.get_ball_revision(index));
+
+    ASSERT_TRUE(loaded.load_scene(path));
+    loaded.add_ball();
+
+    for(unsigned int index{0}; index < loaded.get_ball_count(); index++)
+        EXPECT_GT(loaded.get_ball_revision(index), usedRevision);
+}
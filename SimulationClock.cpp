@@ -0,0 +1,95 @@
+#include "SimulationClock.hpp"
+
+
+SimulationClock::SimulationClock(double fixedTimeStepInput, unsigned int maxStepsPerFrameInput): fixedTimeStep{fixedTimeStepInput}, maxStepsPerFrame{maxStepsPerFrameInput}
+{
+}
+
+unsigned int SimulationClock::tick()
+{
+    std::chrono::steady_clock::time_point now{std::chrono::steady_clock::now()};
+    double elapsedTime{hasLastTick ? std::chrono::duration<double>(now - lastTick).count() : 0.0};
+    lastTick = now;
+    hasLastTick = true;
+    return advance(elapsedTime);
+}
+
+// Returns the number of fixed steps owed for elapsedTime. Anything beyond
+// maxStepsPerFrame is dropped rather than carried over, so a long stall can
+// not snowball into ever longer catch-up frames.
+unsigned int SimulationClock::advance(double elapsedTime)
+{
+    if(elapsedTime > 0)
+        accumulatedTime += elapsedTime;
+
+    unsigned int steps{0};
+    while(accumulatedTime >= fixedTimeStep && steps < maxStepsPerFrame)
+    {
+        accumulatedTime -= fixedTimeStep;
+        steps++;
+    }
+    if(accumulatedTime >= fixedTimeStep)
+    {
+        unsigned long droppedSteps{(unsigned long)(accumulatedTime/fixedTimeStep)};
+        droppedStepCount += droppedSteps;
+        accumulatedTime -= droppedSteps*fixedTimeStep;
+    }
+
+    stepCount += steps;
+    if(steps > 1)
+        extraStepCount += steps - 1;
+    return steps;
+}
+
+void SimulationClock::reset()
+{
+    accumulatedTime = 0;
+    hasLastTick = false;
+}
+
+double SimulationClock::get_fixed_time_step()
+{
+    return this->fixedTimeStep;
+}
+
+unsigned int SimulationClock::get_max_steps_per_frame()
+{
+    return this->maxStepsPerFrame;
+}
+
+double SimulationClock::get_accumulated_time()
+{
+    return this->accumulatedTime;
+}
+
+double SimulationClock::get_alpha()
+{
+    return this->accumulatedTime/fixedTimeStep;
+}
+
+unsigned long SimulationClock::get_step_count()
+{
+    return this->stepCount;
+}
+
+unsigned long SimulationClock::get_dropped_step_count()
+{
+    return this->droppedStepCount;
+}
+
+unsigned long SimulationClock::get_extra_step_count()
+{
+    return this->extraStepCount;
+}
+
+void SimulationClock::set_fixed_time_step(double newTimeStep)
+{
+    if(newTimeStep > 0)
+        this->fixedTimeStep = newTimeStep;
+}
+
+void SimulationClock::set_max_steps_per_frame(unsigned int newMaxSteps)
+{
+    if(newMaxSteps > 0)
+        this->maxStepsPerFrame = newMaxSteps;
+}
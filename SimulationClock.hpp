@@ -0,0 +1,38 @@
+#ifndef SIMULATION_CLOCK_HPP
+#define SIMULATION_CLOCK_HPP
+
+#include <chrono>
+
+
+class SimulationClock
+{
+public:
+    SimulationClock(double fixedTimeStepInput=1.0/120, unsigned int maxStepsPerFrameInput=8);
+
+    unsigned int tick();
+    unsigned int advance(double elapsedTime);
+    void reset();
+
+    double get_fixed_time_step();
+    unsigned int get_max_steps_per_frame();
+    double get_accumulated_time();
+    double get_alpha();
+    unsigned long get_step_count();
+    unsigned long get_dropped_step_count();
+    unsigned long get_extra_step_count();
+
+    void set_fixed_time_step(double newTimeStep);
+    void set_max_steps_per_frame(unsigned int newMaxSteps);
+
+protected:
+    double fixedTimeStep{1.0/120};
+    unsigned int maxStepsPerFrame{8};
+    double accumulatedTime{0};
+    unsigned long stepCount{0};
+    unsigned long droppedStepCount{0};
+    unsigned long extraStepCount{0};
+    bool hasLastTick{false};
+    std::chrono::steady_clock::time_point lastTick;
+};
+
+#endif
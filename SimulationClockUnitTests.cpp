@@ -0,0 +1,68 @@
+#include "gtest/gtest.h"
+#include "SimulationClock.hpp"
+
+
+class SimulationClockTests : public ::testing::Test
+{
+protected:
+    double fixedTimeStep{0.01};
+    unsigned int maxStepsPerFrame{4};
+    SimulationClock clock{SimulationClock(fixedTimeStep, maxStepsPerFrame)};
+};
+
+TEST_F(SimulationClockTests, WhenInitializingClock_ExpectCorrectParameters)
+{
+    EXPECT_EQ(clock.get_fixed_time_step(), fixedTimeStep);
+    EXPECT_EQ(clock.get_max_steps_per_frame(), maxStepsPerFrame);
+    EXPECT_EQ(clock.get_step_count(), 0);
+}
+
+TEST_F(SimulationClockTests, WhenAdvancingLessThanOneStep_ExpectNoStepsAndTimeAccumulated)
+{
+    EXPECT_EQ(clock.advance(0.004), 0);
+    EXPECT_DOUBLE_EQ(clock.get_accumulated_time(), 0.004);
+    EXPECT_DOUBLE_EQ(clock.get_alpha(), 0.4);
+}
+
+TEST_F(SimulationClockTests, WhenAdvancingInSmallIncrements_ExpectStepsOnceTimeAccumulates)
+{
+    unsigned int steps{0};
+    for(int frame{0}; frame < 10; frame++)
+        steps += clock.advance(0.0045);
+
+    EXPECT_EQ(steps, 4);
+    EXPECT_EQ(clock.get_extra_step_count(), 0);
+}
+
+TEST_F(SimulationClockTests, WhenAdvancingSeveralSteps_ExpectSubstepsAndExtraStepCount)
+{
+    EXPECT_EQ(clock.advance(0.0305), 3);
+    EXPECT_EQ(clock.get_extra_step_count(), 2);
+    EXPECT_EQ(clock.get_dropped_step_count(), 0);
+}
+
+TEST_F(SimulationClockTests, WhenAdvancingPastCatchUpBudget_ExpectStepsCappedAndRemainderDropped)
+{
+    EXPECT_EQ(clock.advance(0.1005), maxStepsPerFrame);
+    EXPECT_EQ(clock.get_dropped_step_count(), 6);
+    EXPECT_LT(clock.get_accumulated_time(), fixedTimeStep);
+}
+
+TEST_F(SimulationClockTests, WhenResettingClock_ExpectAccumulatedTimeCleared)
+{
+    clock.advance(0.005);
+
+    clock.reset();
+
+    EXPECT_EQ(clock.get_accumulated_time(), 0);
+    EXPECT_EQ(clock.tick(), 0);
+}
+
+TEST_F(SimulationClockTests, WhenSettingInvalidParameters_ExpectNoChange)
+{
+    clock.set_fixed_time_step(0);
+    clock.set_max_steps_per_frame(0);
+
+    EXPECT_EQ(clock.get_fixed_time_step(), fixedTimeStep);
+    EXPECT_EQ(clock.get_max_steps_per_frame(), maxStepsPerFrame);
+}
@@ -0,0 +1,146 @@
+#include "SimulationHistory.hpp"
+#include <algorithm>
+#include <utility>
+
+
+SimulationHistory::SimulationHistory(unsigned int keyframeIntervalInput, std::size_t memoryBudgetInput)
+    : keyframeInterval{std::max(keyframeIntervalInput, 1u)}, memoryBudget{memoryBudgetInput}
+{
+}
+
+// Called after every step. A step at or before the last recorded one means
+// the simulator was sent back and is now writing a new future, so the old
+// one is thrown away first.
+void SimulationHistory::record(BallPhysics &physics, float deltaTime)
+{
+    unsigned long step{physics.get_step_count()};
+    discard_from(step);
+    if(keyframes.empty() || step - keyframes.back().state.stepCount >= keyframeInterval)
+        capture(physics, deltaTime);
+    else
+        lastStep = step;
+}
+
+// Takes a keyframe of the current step right away, replacing any keyframe
+// at or after it. Used whenever something other than stepping changes the
+// simulator, since replaying from an older keyframe would not see it.
+void SimulationHistory::capture(BallPhysics &physics, float deltaTime)
+{
+    TRACE_SCOPE("SimulationHistory::capture");
+    unsigned long step{physics.get_step_count()};
+    discard_from(step);
+    keyframes.emplace_back();
+    Keyframe &keyframe = keyframes.back();
+    if(!spareStates.empty())
+    {
+        keyframe.state = std::move(spareStates.back());
+        spareStates.pop_back();
+    }
+    physics.save_state(keyframe.state);
+    keyframe.deltaTime = deltaTime;
+    keyframe.memorySize = keyframe.state.get_memory_size();
+    memorySize += keyframe.memorySize;
+    lastStep = step;
+    enforce_memory_budget();
+}
+
+// Leaves the simulator exactly as it was after the given step. The
+// trajectory recorder is detached while replaying so replayed steps are
+// not written twice.
+bool SimulationHistory::seek(BallPhysics &physics, unsigned long step)
+{
+    if(keyframes.empty() || step < keyframes.front().state.stepCount || step > lastStep)
+        return false;
+    TRACE_SCOPE("SimulationHistory::seek");
+    std::deque<Keyframe>::iterator keyframe{std::upper_bound(keyframes.begin(), keyframes.end(), step, [](unsigned long targetStep, const Keyframe &candidate)
+    {
+        return targetStep < candidate.state.stepCount;
+    })};
+    keyframe--;
+
+    physics.restore_state(keyframe->state);
+    TrajectoryRecorder *recorder{physics.get_trajectory_recorder()};
+    physics.set_trajectory_recorder(nullptr);
+    while(physics.get_step_count() < step)
+        physics.update(keyframe->deltaTime);
+    physics.set_trajectory_recorder(recorder);
+    return true;
+}
+
+void SimulationHistory::clear()
+{
+    discard_from(0);
+    lastStep = 0;
+}
+
+bool SimulationHistory::is_empty()
+{
+    return keyframes.empty();
+}
+
+unsigned long SimulationHistory::get_first_step()
+{
+    return keyframes.empty() ? 0 : keyframes.front().state.stepCount;
+}
+
+unsigned long SimulationHistory::get_last_step()
+{
+    return lastStep;
+}
+
+unsigned int SimulationHistory::get_keyframe_count()
+{
+    return keyframes.size();
+}
+
+unsigned int SimulationHistory::get_keyframe_interval()
+{
+    return keyframeInterval;
+}
+
+std::size_t SimulationHistory::get_memory_size()
+{
+    return memorySize;
+}
+
+std::size_t SimulationHistory::get_memory_budget()
+{
+    return memoryBudget;
+}
+
+void SimulationHistory::set_keyframe_interval(unsigned int newInterval)
+{
+    this->keyframeInterval = std::max(newInterval, 1u);
+}
+
+void SimulationHistory::set_memory_budget(std::size_t newBudget)
+{
+    this->memoryBudget = newBudget;
+    enforce_memory_budget();
+}
+
+// Dropped states are kept for the next capture so a running history keeps
+// reusing the same buffers.
+void SimulationHistory::discard_from(unsigned long step)
+{
+    while(!keyframes.empty() && keyframes.back().state.stepCount >= step)
+    {
+        memorySize -= keyframes.back().memorySize;
+        if(spareStates.empty())
+            spareStates.push_back(std::move(keyframes.back().state));
+        keyframes.pop_back();
+    }
+}
+
+// The newest keyframe always stays, even over budget, so the current step
+// remains reachable.
+void SimulationHistory::enforce_memory_budget()
+{
+    while(keyframes.size() > 1 && memorySize > memoryBudget)
+    {
+        memorySize -= keyframes.front().memorySize;
+        if(spareStates.empty())
+            spareStates.push_back(std::move(keyframes.front().state));
+        keyframes.pop_front();
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef SIMULATION_HISTORY_HPP
+#define SIMULATION_HISTORY_HPP
+
+#include "BallPhysics.hpp"
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+// Keeps full simulator states every keyframeInterval steps and reaches any
+// step in between by restoring the keyframe before it and stepping forward,
+// which replays exactly because stepping is deterministic. Once the
+// keyframes outgrow the memory budget the oldest ones are dropped, so the
+// reachable range shrinks rather than the seek cost growing.
+class SimulationHistory
+{
+public:
+    SimulationHistory(unsigned int keyframeIntervalInput=120, std::size_t memoryBudgetInput=std::size_t(256) << 20);
+
+    void record(BallPhysics &physics, float deltaTime);
+    void capture(BallPhysics &physics, float deltaTime);
+    bool seek(BallPhysics &physics, unsigned long step);
+    void clear();
+
+    bool is_empty();
+    unsigned long get_first_step();
+    unsigned long get_last_step();
+    unsigned int get_keyframe_count();
+    unsigned int get_keyframe_interval();
+    std::size_t get_memory_size();
+    std::size_t get_memory_budget();
+
+    void set_keyframe_interval(unsigned int newInterval);
+    void set_memory_budget(std::size_t newBudget);
+
+protected:
+    struct Keyframe
+    {
+        float deltaTime;
+        std::size_t memorySize;
+        BallPhysicsState state;
+    };
+
+    void discard_from(unsigned long step);
+    void enforce_memory_budget();
+
+    unsigned int keyframeInterval{120};
+    std::size_t memoryBudget{std::size_t(256) << 20};
+    std::deque<Keyframe> keyframes;
+    std::vector<BallPhysicsState> spareStates;
+    std::size_t memorySize{0};
+    unsigned long lastStep{0};
+};
+
+#endif
@@ -0,0 +1,165 @@
+#include "gtest/gtest.h"
+#include "BallPhysics.hpp"
+#include "SimulationHistory.hpp"
+
+
+class SimulationHistoryTests : public ::testing::Test
+{
+protected:
+    void SetUp();
+    void run(unsigned int stepCount);
+    void remember_state(BallPhysicsState &state);
+    void EXPECT_STATE_EQ(const BallPhysicsState &state);
+
+    BallPhysics fountain{BallPhysics(10, 1.2, -9.81, 400)};
+    SimulationHistory history{SimulationHistory(50)};
+    float stepTime{1.0/120};
+};
+
+void SimulationHistoryTests::SetUp()
+{
+    fountain.set_thread_count(2);
+    Emitter nozzle(Eigen::Vector3f{0, 0, 0.5}, Eigen::Vector3f{0, 0, 1}, 15, 400);
+    nozzle.set_spread_angle(0.3);
+    fountain.add_emitter(nozzle);
+    history.capture(fountain, stepTime);
+}
+
+void SimulationHistoryTests::run(unsigned int stepCount)
+{
+    for(unsigned int step{0}; step < stepCount; step++)
+    {
+        fountain.update(stepTime);
+        history.record(fountain, stepTime);
+    }
+}
+
+void SimulationHistoryTests::remember_state(BallPhysicsState &state)
+{
+    fountain.save_state(state);
+}
+
+void SimulationHistoryTests::EXPECT_STATE_EQ(const BallPhysicsState &state)
+{
+    ASSERT_EQ(fountain.get_step_count(), state.stepCount);
+    ASSERT_EQ(fountain.get_ball_count(), state.ballCount);
+    EXPECT_EQ(fountain.get_awake_ball_count(), state.awakeCount);
+    EXPECT_EQ(fountain.get_gravity(), state.gravity);
+    for(unsigned int index{0}; index < state.ballCount; index++)
+    {
+        ASSERT_EQ(fountain.get_ball_ptr(index)->position[0], state.balls.positionX[index]);
+        ASSERT_EQ(fountain.get_ball_ptr(index)->position[1], state.balls.positionY[index]);
+        ASSERT_EQ(fountain.get_ball_ptr(index)->position[2], state.balls.positionZ[index]);
+        ASSERT_EQ(fountain.get_ball_ptr(index)->velocity[2], state.balls.velocityZ[index]);
+        ASSERT_EQ(fountain.get_ball_handle(index).slot, state.ballSlots[index]);
+        ASSERT_EQ(fountain.get_ball_revision(index), state.balls.revision[index]);
+    }
+}
+
+TEST_F(SimulationHistoryTests, WhenRecordingSteps_ExpectKeyframeEveryInterval)
+{
+    run(300);
+
+    EXPECT_EQ(history.get_keyframe_count(), 7);
+    EXPECT_EQ(history.get_first_step(), 0);
+    EXPECT_EQ(history.get_last_step(), 300);
+    EXPECT_GT(history.get_memory_size(), 0);
+}
+
+TEST_F(SimulationHistoryTests, WhenSeekingBetweenKeyframes_ExpectSameStateAsOriginalRun)
+{
+    BallPhysicsState expected;
+    run(173);
+    remember_state(expected);
+    run(200);
+
+    ASSERT_TRUE(history.seek(fountain, 173));
+
+    EXPECT_STATE_EQ(expected);
+}
+
+TEST_F(SimulationHistoryTests, WhenContinuingAfterSeek_ExpectSameFutureAsOriginalRun)
+{
+    BallPhysicsState expected;
+    run(300);
+    remember_state(expected);
+
+    ASSERT_TRUE(history.seek(fountain, 120));
+    run(180);
+
+    EXPECT_STATE_EQ(expected);
+    EXPECT_EQ(history.get_last_step(), 300);
+}
+
+TEST_F(SimulationHistoryTests, WhenParametersChangeWithCapture_ExpectSeekOnBothSidesToMatch)
+{
+    BallPhysicsState before, after;
+    run(80);
+    remember_state(before);
+    run(20);
+    fountain.set_gravity(-3);
+    history.capture(fountain, stepTime);
+    run(30);
+    remember_state(after);
+    run(40);
+
+    ASSERT_TRUE(history.seek(fountain, 130));
+    EXPECT_STATE_EQ(after);
+    ASSERT_TRUE(history.seek(fountain, 80));
+    EXPECT_STATE_EQ(before);
+}
+
+TEST_F(SimulationHistoryTests, WhenResumingAfterRewind_ExpectOldFutureDiscarded)
+{
+    run(300);
+    ASSERT_TRUE(history.seek(fountain, 110));
+
+    run(10);
+
+    EXPECT_EQ(history.get_last_step(), 120);
+    EXPECT_EQ(history.get_keyframe_count(), 3);
+    EXPECT_FALSE(history.seek(fountain, 200));
+}
+
+TEST_F(SimulationHistoryTests, WhenOverMemoryBudget_ExpectOldestKeyframesDropped)
+{
+    BallPhysicsState fullState;
+    run(200);
+    remember_state(fullState);
+    std::size_t keyframeSize{fullState.get_memory_size()};
+    history.set_memory_budget(3*keyframeSize + keyframeSize/2);
+
+    run(300);
+
+    EXPECT_LE(history.get_memory_size(), history.get_memory_budget());
+    EXPECT_EQ(history.get_keyframe_count(), 3);
+    EXPECT_EQ(history.get_first_step(), 400);
+    EXPECT_FALSE(history.seek(fountain, 399));
+    EXPECT_TRUE(history.seek(fountain, 400));
+}
+
+TEST_F(SimulationHistoryTests, WhenSeekingOutsideRecordedSteps_ExpectFailureAndStateUntouched)
+{
+    run(60);
+
+    EXPECT_FALSE(history.seek(fountain, 61));
+    EXPECT_EQ(fountain.get_step_count(), 60);
+    history.clear();
+    EXPECT_TRUE(history.is_empty());
+    EXPECT_FALSE(history.seek(fountain, 10));
+}
+
+TEST_F(SimulationHistoryTests, WhenSeeking_ExpectSnapshotsMarkedRestored)
+{
+    run(100);
+    fountain.publish_snapshot();
+    SnapshotTripleBuffer *snapshots = fountain.get_snapshot_buffer();
+    ASSERT_TRUE(snapshots->acquire_latest());
+    unsigned int restoreCount{snapshots->get_front().restoreCount};
+
+    ASSERT_TRUE(history.seek(fountain, 50));
+    fountain.publish_snapshot();
+
+    ASSERT_TRUE(snapshots->acquire_latest());
+    EXPECT_NE(snapshots->get_front().restoreCount, restoreCount);
+}
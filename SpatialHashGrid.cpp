@@ -0,0 +1,150 @@
+#include "SpatialHashGrid.hpp"
+#include <algorithm>
+#include <math.h>
+
+
+void SpatialHashGrid::reserve(unsigned int capacity)
+{
+    unsigned int requiredSize{1};
+    while(requiredSize < 2*capacity)
+        requiredSize <<= 1;
+    ballCellX.reserve(capacity);
+    ballCellY.reserve(capacity);
+    ballCellZ.reserve(capacity);
+    cellEntries.reserve(capacity);
+    cellStart.reserve(requiredSize + 1);
+}
+
+void SpatialHashGrid::build(const BallStorage &balls, unsigned int count, float boxBoundSizeInput)
+{
+    this->ballCount = count;
+    this->boxBoundSize = boxBoundSizeInput;
+
+    float maxRadius{0};
+    for(unsigned int ballIndex{0}; ballIndex < ballCount; ballIndex++)
+        maxRadius = fmax(maxRadius, balls.radius[ballIndex]);
+    this->cellSize = maxRadius > 0 ? 2*maxRadius : 1;
+
+    unsigned int requiredSize{1};
+    while(requiredSize < 2*ballCount)
+        requiredSize <<= 1;
+    this->tableSize = requiredSize;
+
+    ballCellX.resize(ballCount);
+    ballCellY.resize(ballCount);
+    ballCellZ.resize(ballCount);
+    cellEntries.resize(ballCount);
+    cellStart.assign(tableSize + 1, 0);
+
+    for(unsigned int ballIndex{0}; ballIndex < ballCount; ballIndex++)
+    {
+        ballCellX[ballIndex] = int(floor((balls.positionX[ballIndex] + boxBoundSize)/cellSize));
+        ballCellY[ballIndex] = int(floor((balls.positionY[ballIndex] + boxBoundSize)/cellSize));
+        ballCellZ[ballIndex] = int(floor(balls.positionZ[ballIndex]/cellSize));
+        cellStart[hash_cell(ballCellX[ballIndex], ballCellY[ballIndex], ballCellZ[ballIndex])]++;
+    }
+
+    for(unsigned int cell{0}; cell < tableSize; cell++)
+        cellStart[cell + 1] += cellStart[cell];
+
+    for(unsigned int ballIndex{ballCount}; ballIndex-- > 0;)
+    {
+        unsigned int cell = hash_cell(ballCellX[ballIndex], ballCellY[ballIndex], ballCellZ[ballIndex]);
+        cellEntries[--cellStart[cell]] = ballIndex;
+    }
+}
+
+void SpatialHashGrid::find_pairs(std::vector<BallPair> &pairs)
+{
+    find_pairs(pairs, ballCount);
+}
+
+// Only balls below activeCount start a search. Every ball at or above it
+// still shows up as the second ball of a pair, but pairs between two of
+// them are skipped.
+void SpatialHashGrid::find_pairs(std::vector<BallPair> &pairs, unsigned int activeCount)
+{
+    pairs.clear();
+    for(unsigned int ballIndex{0}; ballIndex < std::min(activeCount, ballCount); ballIndex++)
+    {
+        for(int offsetZ{-1}; offsetZ <= 1; offsetZ++)
+        {
+            for(int offsetY{-1}; offsetY <= 1; offsetY++)
+            {
+                for(int offsetX{-1}; offsetX <= 1; offsetX++)
+                {
+                    int cellX{ballCellX[ballIndex] + offsetX};
+                    int cellY{ballCellY[ballIndex] + offsetY};
+                    int cellZ{ballCellZ[ballIndex] + offsetZ};
+                    unsigned int cell{hash_cell(cellX, cellY, cellZ)};
+                    for(unsigned int entry{cellStart[cell]}; entry < cellStart[cell + 1]; entry++)
+                    {
+                        unsigned int candidateIndex{cellEntries[entry]};
+                        if(candidateIndex <= ballIndex)
+                            continue;
+                        if(ballCellX[candidateIndex] != cellX || ballCellY[candidateIndex] != cellY || ballCellZ[candidateIndex] != cellZ)
+                            continue;
+                        pairs.push_back(BallPair{ballIndex, candidateIndex});
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Gives every ball whose cell overlaps the box, each once. A box covering
+// more cells than there are balls is answered by checking every ball.
+void SpatialHashGrid::find_in_bounds(Eigen::Vector3f lower, Eigen::Vector3f upper, std::vector<unsigned int> &indices)
+{
+    indices.clear();
+    int lowerX{int(floor((lower[0] + boxBoundSize)/cellSize))};
+    int lowerY{int(floor((lower[1] + boxBoundSize)/cellSize))};
+    int lowerZ{int(floor(lower[2]/cellSize))};
+    int upperX{int(floor((upper[0] + boxBoundSize)/cellSize))};
+    int upperY{int(floor((upper[1] + boxBoundSize)/cellSize))};
+    int upperZ{int(floor(upper[2]/cellSize))};
+    double cellCount{double(upperX - lowerX + 1)*(upperY - lowerY + 1)*(upperZ - lowerZ + 1)};
+    if(cellCount > ballCount)
+    {
+        for(unsigned int ballIndex{0}; ballIndex < ballCount; ballIndex++)
+        {
+            if(ballCellX[ballIndex] >= lowerX && ballCellX[ballIndex] <= upperX && ballCellY[ballIndex] >= lowerY && ballCellY[ballIndex] <= upperY
+               && ballCellZ[ballIndex] >= lowerZ && ballCellZ[ballIndex] <= upperZ)
+                indices.push_back(ballIndex);
+        }
+        return;
+    }
+
+    for(int cellZ{lowerZ}; cellZ <= upperZ; cellZ++)
+    {
+        for(int cellY{lowerY}; cellY <= upperY; cellY++)
+        {
+            for(int cellX{lowerX}; cellX <= upperX; cellX++)
+            {
+                unsigned int cell{hash_cell(cellX, cellY, cellZ)};
+                for(unsigned int entry{cellStart[cell]}; entry < cellStart[cell + 1]; entry++)
+                {
+                    unsigned int ballIndex{cellEntries[entry]};
+                    if(ballCellX[ballIndex] == cellX && ballCellY[ballIndex] == cellY && ballCellZ[ballIndex] == cellZ)
+                        indices.push_back(ballIndex);
+                }
+            }
+        }
+    }
+}
+
+float SpatialHashGrid::get_cell_size()
+{
+    return this->cellSize;
+}
+
+unsigned int SpatialHashGrid::get_table_size()
+{
+    return this->tableSize;
+}
+
+unsigned int SpatialHashGrid::hash_cell(int cellX, int cellY, int cellZ)
+{
+    unsigned int hash{(unsigned int)(cellX)*73856093u ^ (unsigned int)(cellY)*19349663u ^ (unsigned int)(cellZ)*83492791u};
+    return hash & (tableSize - 1);
+}
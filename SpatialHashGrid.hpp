@@ -0,0 +1,33 @@
+#ifndef SPATIAL_HASH_GRID_HPP
+#define SPATIAL_HASH_GRID_HPP
+
+#include "Broadphase.hpp"
+#include <vector>
+
+class SpatialHashGrid : public Broadphase
+{
+public:
+    void reserve(unsigned int capacity);
+    void build(const BallStorage &balls, unsigned int ballCount, float boxBoundSize);
+    void find_pairs(std::vector<BallPair> &pairs);
+    void find_pairs(std::vector<BallPair> &pairs, unsigned int activeCount);
+    void find_in_bounds(Eigen::Vector3f lower, Eigen::Vector3f upper, std::vector<unsigned int> &indices);
+
+    float get_cell_size();
+    unsigned int get_table_size();
+
+protected:
+    unsigned int hash_cell(int cellX, int cellY, int cellZ);
+
+    float cellSize{1};
+    float boxBoundSize{0};
+    unsigned int tableSize{0};
+    unsigned int ballCount{0};
+    std::vector<int> ballCellX;
+    std::vector<int> ballCellY;
+    std::vector<int> ballCellZ;
+    std::vector<unsigned int> cellStart;
+    std::vector<unsigned int> cellEntries;
+};
+
+#endif
@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+#include "SpatialHashGrid.hpp"
+
+#include <algorithm>
+#include <random>
+
+
+class SpatialHashGridTests : public ::testing::Test
+{
+protected:
+    void add_ball(float radius, Eigen::Vector3f position);
+    SpatialHashGrid grid;
+    BallStorage balls;
+    std::vector<BallPair> pairs;
+    float boxSize{30};
+};
+
+void SpatialHashGridTests::add_ball(float radius, Eigen::Vector3f position)
+{
+    Ball ball;
+    ball.radius = radius;
+    ball.position = position;
+    balls.push_back(ball);
+}
+
+TEST_F(SpatialHashGridTests, WhenBuildingGrid_ExpectCellSizeOfLargestDiameter)
+{
+    add_ball(0.5, Eigen::Vector3f{0, 0, 1});
+    add_ball(2, Eigen::Vector3f{5, 5, 5});
+
+    grid.build(balls, balls.size(), boxSize);
+
+    EXPECT_EQ(grid.get_cell_size(), 4);
+}
+
+TEST_F(SpatialHashGridTests, WhenBallsOverlap_ExpectSingleUniquePair)
+{
+    add_ball(1, Eigen::Vector3f{0, 0, 1});
+    add_ball(1, Eigen::Vector3f{1.5, 0, 1});
+
+    grid.build(balls, balls.size(), boxSize);
+    grid.find_pairs(pairs);
+
+    ASSERT_EQ(pairs.size(), 1);
+    EXPECT_EQ(pairs[0].first, 0);
+    EXPECT_EQ(pairs[0].second, 1);
+}
+
+TEST_F(SpatialHashGridTests, WhenBallsAreFarApart_ExpectNoPairs)
+{
+    add_ball(1, Eigen::Vector3f{-20, -20, 1});
+    add_ball(1, Eigen::Vector3f{20, 20, 40});
+
+    grid.build(balls, balls.size(), boxSize);
+    grid.find_pairs(pairs);
+
+    EXPECT_TRUE(pairs.empty());
+}
+
+TEST_F(SpatialHashGridTests, WhenFindingPairsInRandomScene_ExpectEveryOverlappingPairExactlyOnce)
+{
+    std::mt19937 generator{7};
+    std::uniform_real_distribution<float> coordinate{-boxSize, boxSize};
+    std::uniform_real_distribution<float> height{0, 20};
+    std::uniform_real_distribution<float> radius{0.1, 1.5};
+    for(int count{0}; count < 2000; count++)
+        add_ball(radius(generator), Eigen::Vector3f{coordinate(generator), coordinate(generator), height(generator)});
+
+    grid.build(balls, balls.size(), boxSize);
+    grid.find_pairs(pairs);
+
+    std::vector<std::pair<unsigned int, unsigned int>> found;
+    for(const BallPair &pair : pairs)
+    {
+        float distance = (balls.get_position(pair.first) - balls.get_position(pair.second)).norm();
+        if(distance < balls.radius[pair.first] + balls.radius[pair.second])
+            found.push_back(std::make_pair(pair.first, pair.second));
+    }
+    std::vector<std::pair<unsigned int, unsigned int>> expected;
+    for(unsigned int first{0}; first < balls.size(); first++)
+    {
+        for(unsigned int second{first + 1}; second < balls.size(); second++)
+        {
+            float distance = (balls.get_position(first) - balls.get_position(second)).norm();
+            if(distance < balls.radius[first] + balls.radius[second])
+                expected.push_back(std::make_pair(first, second));
+        }
+    }
+    std::sort(found.begin(), found.end());
+
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(found, expected);
+}
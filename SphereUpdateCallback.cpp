@@ -1,25 +1,57 @@
 #include "SphereUpdateCallback.hpp"
 
 
-SphereUpdateCallback::SphereUpdateCallback(BallPhysics *systemPhysics): physicsPtr{systemPhysics}
+SphereUpdateCallback::SphereUpdateCallback(const SnapshotTripleBuffer *systemSnapshots, SimulationClock *systemClock, osg::Geometry *instancedSphereGeometry): snapshotsPtr{systemSnapshots}, clockPtr{systemClock}, sphereGeometry{instancedSphereGeometry}
 {
 }
 
-void SphereUpdateCallback::operator()(osg::Node* node, osg::NodeVisitor* visitingNode)
+// Sizes the instance arrays for capacity balls up front so frames never
+// grow them.
+void SphereUpdateCallback::reserve(unsigned int capacity)
 {
-    osg::Group *parent = node->getParent(0);
-    int nodeNumber = parent->getChildIndex(node);
-
-    osg::Vec3f positionOfBall(physicsPtr->get_ball_ptr(nodeNumber-2)->position[0], physicsPtr->get_ball_ptr(nodeNumber-2)->position[1], physicsPtr->get_ball_ptr(nodeNumber-2)->position[2]);
-    osg::PositionAttitudeTransform *ballTransformation = dynamic_cast<osg::PositionAttitudeTransform *> (node);
-    ballTransformation->setPosition(positionOfBall);
+    static_cast<osg::Vec4Array *>(sphereGeometry->getVertexAttribArray(instancedsphere::positionRadiusAttribute))->reserve(capacity);
+    static_cast<osg::Vec4Array *>(sphereGeometry->getVertexAttribArray(instancedsphere::colorAttribute))->reserve(capacity);
+    renderedRevisions.reserve(capacity);
+}
 
-    osg::Geode *ballGeode = ballTransformation->getChild(0)->asGeode();
-    osg::ShapeDrawable *ballShapeDrawable = dynamic_cast<osg::ShapeDrawable *> (ballGeode->getDrawable(0));
-    ballShapeDrawable->setColor(osgwidgetutils::hue_to_osg_rgba_decimal(physicsPtr->get_ball_ptr(nodeNumber-2)->color));
+void SphereUpdateCallback::operator()(osg::Node* node, osg::NodeVisitor* visitingNode)
+{
+    const BallSnapshot &snapshot = snapshotsPtr->get_front();
+    osg::Vec4Array *instancePositionRadii = static_cast<osg::Vec4Array *>(sphereGeometry->getVertexAttribArray(instancedsphere::positionRadiusAttribute));
+    osg::Vec4Array *instanceColors = static_cast<osg::Vec4Array *>(sphereGeometry->getVertexAttribArray(instancedsphere::colorAttribute));
+    osg::PrimitiveSet *triangles = sphereGeometry->getPrimitiveSet(0);
 
-    osg::Sphere *ball = new osg::Sphere(osg::Vec3(0.f, 0.f, 0.f), physicsPtr->get_ball_ptr(nodeNumber-2)->radius);
-    ballShapeDrawable->setShape(ball);
+    float alpha{float(clockPtr->get_alpha())};
+    osg::BoundingBox ballBounds;
+    unsigned int instanceCount{snapshot.ballCount > 0 ? snapshot.ballCount : 1};
+    bool colorsChanged{instanceColors->size() != instanceCount};
+    bool stateRestored{snapshot.restoreCount != renderedRestoreCount};
+    renderedRestoreCount = snapshot.restoreCount;
+    instancePositionRadii->resize(instanceCount);
+    instanceColors->resize(instanceCount);
+    renderedRevisions.resize(snapshot.ballCount, 0);
+    if(snapshot.ballCount == 0)
+        (*instancePositionRadii)[0] = osg::Vec4(0.f, 0.f, 0.f, 0.f);
+    for(unsigned int ballIndex{0}; ballIndex < snapshot.ballCount; ballIndex++)
+    {
+        Eigen::Vector3f interpolatedPosition{snapshot.get_interpolated_position(ballIndex, alpha)};
+        osg::Vec3 positionOfBall(interpolatedPosition[0], interpolatedPosition[1], interpolatedPosition[2]);
+        (*instancePositionRadii)[ballIndex] = osg::Vec4(positionOfBall, snapshot.radius[ballIndex]);
+        ballBounds.expandBy(osg::BoundingSphere(positionOfBall, snapshot.radius[ballIndex]));
+        if(stateRestored || renderedRevisions[ballIndex] != snapshot.revision[ballIndex])
+        {
+            (*instanceColors)[ballIndex] = osgwidgetutils::hue_to_osg_rgba_decimal(snapshot.color[ballIndex]);
+            renderedRevisions[ballIndex] = snapshot.revision[ballIndex];
+            colorsChanged = true;
+        }
+    }
+    instancePositionRadii->dirty();
+    if(colorsChanged)
+        instanceColors->dirty();
+    triangles->setNumInstances(instanceCount);
+    triangles->dirty();
+    sphereGeometry->setInitialBound(ballBounds);
+    sphereGeometry->dirtyBound();
 
     traverse(node, visitingNode);
 }
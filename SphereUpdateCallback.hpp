@@ -1,14 +1,13 @@
 #ifndef SPHERE_UPDATE_HPP
 #define SPHERE_UPDATE_HPP
 
-#include "BallPhysics.hpp"
+#include "BallSnapshot.hpp"
 #include "OSGWidgetUtils.hpp"
+#include "SimulationClock.hpp"
+#include "InstancedSphereGeometry.hpp"
 
 #include <osg/NodeVisitor>
-#include <osg/PositionAttitudeTransform>
-#include <osg/Material>
-#include <osg/ShapeDrawable>
-#include <osg/Shape>
+#include <osg/Geometry>
 #include <osg/Geode>
 
 #include <vector>
@@ -18,11 +17,16 @@
 class SphereUpdateCallback: public osg::NodeCallback
 {
 public:
-    SphereUpdateCallback(BallPhysics *systemPhysics);
+    SphereUpdateCallback(const SnapshotTripleBuffer *systemSnapshots, SimulationClock *systemClock, osg::Geometry *instancedSphereGeometry);
     virtual void operator()(osg::Node* node, osg::NodeVisitor* nodeVisitor);
+    void reserve(unsigned int capacity);
 
 protected:
-    BallPhysics *physicsPtr;
+    const SnapshotTripleBuffer *snapshotsPtr;
+    SimulationClock *clockPtr;
+    osg::ref_ptr<osg::Geometry> sphereGeometry;
+    std::vector<unsigned int> renderedRevisions;
+    unsigned int renderedRestoreCount{0};
 
 };
 
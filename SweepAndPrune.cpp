@@ -0,0 +1,135 @@
+#include "SweepAndPrune.hpp"
+#include <algorithm>
+#include <math.h>
+
+
+namespace
+{
+bool sorts_before(const SweepEntry &first, const SweepEntry &second)
+{
+    return first.lower < second.lower || (first.lower == second.lower && first.ball < second.ball);
+}
+}
+
+void SweepAndPrune::reserve(unsigned int capacity)
+{
+    entries.reserve(capacity);
+}
+
+// Entries of removed balls are dropped and new balls appended before the
+// bounds are refreshed. A new axis, or a list that is mostly new, is sorted
+// from scratch instead; both sorts give the same order.
+void SweepAndPrune::build(const BallStorage &balls, unsigned int count, float /*boxBoundSize*/)
+{
+    if(count < ballCount)
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [count](const SweepEntry &entry)
+        {
+            return entry.ball >= count;
+        }), entries.end());
+    unsigned int keptCount{std::min(count, ballCount)};
+    for(unsigned int ballIndex{keptCount}; ballIndex < count; ballIndex++)
+        entries.push_back(SweepEntry{0, 0, 0, 0, 0, ballIndex});
+    this->ballCount = count;
+
+    unsigned int newAxis{choose_sort_axis(balls)};
+    const float *axisPosition[3]{balls.positionX.data(), balls.positionY.data(), balls.positionZ.data()};
+    const float *sortPosition{axisPosition[newAxis]};
+    const float *positionA{axisPosition[(newAxis + 1)%3]};
+    const float *positionB{axisPosition[(newAxis + 2)%3]};
+    for(SweepEntry &entry : entries)
+    {
+        float radius{balls.radius[entry.ball]};
+        entry.lower = sortPosition[entry.ball] - radius;
+        entry.upper = sortPosition[entry.ball] + radius;
+        entry.centerA = positionA[entry.ball];
+        entry.centerB = positionB[entry.ball];
+        entry.radius = radius;
+    }
+
+    if(newAxis != sortAxis || 2*keptCount < ballCount)
+    {
+        std::sort(entries.begin(), entries.end(), sorts_before);
+        lastSwapCount = 0;
+    }
+    else
+        insertion_sort();
+    this->sortAxis = newAxis;
+}
+
+// Pairs come out in sweep order with the smaller index first.
+void SweepAndPrune::find_pairs(std::vector<BallPair> &pairs, unsigned int activeCount)
+{
+    pairs.clear();
+    unsigned int entryCount{(unsigned int)entries.size()};
+    for(unsigned int entryIndex{0}; entryIndex < entryCount; entryIndex++)
+    {
+        const SweepEntry &entry = entries[entryIndex];
+        for(unsigned int candidateIndex{entryIndex + 1}; candidateIndex < entryCount && entries[candidateIndex].lower <= entry.upper; candidateIndex++)
+        {
+            const SweepEntry &candidate = entries[candidateIndex];
+            if(entry.ball >= activeCount && candidate.ball >= activeCount)
+                continue;
+            float reach{entry.radius + candidate.radius};
+            if(fabs(candidate.centerA - entry.centerA) > reach || fabs(candidate.centerB - entry.centerB) > reach)
+                continue;
+            pairs.push_back(BallPair{std::min(entry.ball, candidate.ball), std::max(entry.ball, candidate.ball)});
+        }
+    }
+}
+
+unsigned int SweepAndPrune::get_sort_axis()
+{
+    return this->sortAxis;
+}
+
+unsigned long SweepAndPrune::get_last_swap_count()
+{
+    return this->lastSwapCount;
+}
+
+// The axis with the largest spread of ball centres separates the most
+// intervals. It only depends on the balls, never on the previous axis.
+unsigned int SweepAndPrune::choose_sort_axis(const BallStorage &balls)
+{
+    if(ballCount == 0)
+        return sortAxis;
+    const float *axisPosition[3]{balls.positionX.data(), balls.positionY.data(), balls.positionZ.data()};
+    unsigned int bestAxis{0};
+    double bestVariance{-1};
+    for(unsigned int axis{0}; axis < 3; axis++)
+    {
+        double sum{0};
+        double squareSum{0};
+        for(unsigned int ballIndex{0}; ballIndex < ballCount; ballIndex++)
+        {
+            sum += axisPosition[axis][ballIndex];
+            squareSum += double(axisPosition[axis][ballIndex])*axisPosition[axis][ballIndex];
+        }
+        double variance{squareSum/ballCount - (sum/ballCount)*(sum/ballCount)};
+        if(variance > bestVariance)
+        {
+            bestVariance = variance;
+            bestAxis = axis;
+        }
+    }
+    return bestAxis;
+}
+
+void SweepAndPrune::insertion_sort()
+{
+    lastSwapCount = 0;
+    for(unsigned int entryIndex{1}; entryIndex < entries.size(); entryIndex++)
+    {
+        if(!sorts_before(entries[entryIndex], entries[entryIndex - 1]))
+            continue;
+        SweepEntry entry{entries[entryIndex]};
+        unsigned int position{entryIndex};
+        while(position > 0 && sorts_before(entry, entries[position - 1]))
+        {
+            entries[position] = entries[position - 1];
+            position--;
+        }
+        entries[position] = entry;
+        lastSwapCount += entryIndex - position;
+    }
+}
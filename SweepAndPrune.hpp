@@ -0,0 +1,43 @@
+#ifndef SWEEP_AND_PRUNE_HPP
+#define SWEEP_AND_PRUNE_HPP
+
+#include "Broadphase.hpp"
+#include <vector>
+
+struct SweepEntry
+{
+    float lower;
+    float upper;
+    float centerA;
+    float centerB;
+    float radius;
+    unsigned int ball;
+};
+
+// Sorts ball intervals along the axis the balls are most spread out on and
+// sweeps them, checking the other two axes only for intervals that overlap.
+// The sorted list is kept between builds and fixed up by insertion sort, so
+// when balls move a little per step sorting costs about one pass. Ties sort
+// by ball index, which makes the order, and so the pairs, independent of
+// what was sorted before.
+class SweepAndPrune : public Broadphase
+{
+public:
+    void reserve(unsigned int capacity);
+    void build(const BallStorage &balls, unsigned int ballCount, float boxBoundSize);
+    void find_pairs(std::vector<BallPair> &pairs, unsigned int activeCount);
+
+    unsigned int get_sort_axis();
+    unsigned long get_last_swap_count();
+
+protected:
+    unsigned int choose_sort_axis(const BallStorage &balls);
+    void insertion_sort();
+
+    unsigned int ballCount{0};
+    unsigned int sortAxis{0};
+    unsigned long lastSwapCount{0};
+    std::vector<SweepEntry> entries;
+};
+
+#endif
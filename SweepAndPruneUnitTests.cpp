@@ -0,0 +1,143 @@
+#include "gtest/gtest.h"
+#include "SweepAndPrune.hpp"
+#include "BruteForceBroadphase.hpp"
+#include "SpatialHashGrid.hpp"
+
+#include <algorithm>
+#include <random>
+
+
+class SweepAndPruneTests : public ::testing::Test
+{
+protected:
+    void add_ball(float radius, Eigen::Vector3f position);
+    void add_random_balls(unsigned int count);
+    std::vector<std::pair<unsigned int, unsigned int>> find_touching_pairs(Broadphase &broadphase, unsigned int activeCount);
+    SweepAndPrune sweep;
+    BallStorage balls;
+    std::vector<BallPair> pairs;
+    float boxSize{30};
+};
+
+void SweepAndPruneTests::add_ball(float radius, Eigen::Vector3f position)
+{
+    Ball ball;
+    ball.radius = radius;
+    ball.position = position;
+    balls.push_back(ball);
+}
+
+void SweepAndPruneTests::add_random_balls(unsigned int count)
+{
+    std::mt19937 generator{7};
+    std::uniform_real_distribution<float> coordinate{-boxSize, boxSize};
+    std::uniform_real_distribution<float> height{0, 20};
+    std::uniform_real_distribution<float> radius{0.1, 1.5};
+    for(unsigned int ballIndex{0}; ballIndex < count; ballIndex++)
+        add_ball(radius(generator), Eigen::Vector3f{coordinate(generator), coordinate(generator), height(generator)});
+}
+
+std::vector<std::pair<unsigned int, unsigned int>> SweepAndPruneTests::find_touching_pairs(Broadphase &broadphase, unsigned int activeCount)
+{
+    broadphase.build(balls, balls.size(), boxSize);
+    broadphase.find_pairs(pairs, activeCount);
+    std::vector<std::pair<unsigned int, unsigned int>> found;
+    for(const BallPair &pair : pairs)
+    {
+        EXPECT_LT(pair.first, pair.second);
+        float distance = (balls.get_position(pair.first) - balls.get_position(pair.second)).norm();
+        if(distance < balls.radius[pair.first] + balls.radius[pair.second])
+            found.push_back(std::make_pair(pair.first, pair.second));
+    }
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+TEST_F(SweepAndPruneTests, WhenBallsOverlap_ExpectSingleOrderedPair)
+{
+    add_ball(1, Eigen::Vector3f{1.5, 0, 1});
+    add_ball(1, Eigen::Vector3f{0, 0, 1});
+
+    sweep.build(balls, balls.size(), boxSize);
+    sweep.find_pairs(pairs, balls.size());
+
+    ASSERT_EQ(pairs.size(), 1);
+    EXPECT_EQ(pairs[0].first, 0);
+    EXPECT_EQ(pairs[0].second, 1);
+}
+
+TEST_F(SweepAndPruneTests, WhenIntervalsOverlapOnlyOnSortAxis_ExpectNoPairs)
+{
+    add_ball(1, Eigen::Vector3f{0, -20, 1});
+    add_ball(1, Eigen::Vector3f{0, 20, 1});
+    add_ball(1, Eigen::Vector3f{0, 0, 1});
+    add_ball(1, Eigen::Vector3f{10, 0.5, 1});
+
+    sweep.build(balls, balls.size(), boxSize);
+    sweep.find_pairs(pairs, balls.size());
+
+    EXPECT_EQ(sweep.get_sort_axis(), 1);
+    EXPECT_TRUE(pairs.empty());
+}
+
+TEST_F(SweepAndPruneTests, WhenFindingPairsInRandomScene_ExpectSameTouchingPairsAsOtherBroadphases)
+{
+    add_random_balls(2000);
+    BruteForceBroadphase bruteForce;
+    SpatialHashGrid grid;
+
+    std::vector<std::pair<unsigned int, unsigned int>> expected{find_touching_pairs(bruteForce, balls.size())};
+
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(find_touching_pairs(sweep, balls.size()), expected);
+    EXPECT_EQ(find_touching_pairs(grid, balls.size()), expected);
+}
+
+TEST_F(SweepAndPruneTests, WhenOnlySomeBallsActive_ExpectSameTouchingPairsAsBruteForce)
+{
+    add_random_balls(2000);
+    BruteForceBroadphase bruteForce;
+
+    EXPECT_EQ(find_touching_pairs(sweep, 700), find_touching_pairs(bruteForce, 700));
+}
+
+TEST_F(SweepAndPruneTests, WhenBallsBarelyMove_ExpectFewSwapsAndSamePairsAsFreshSort)
+{
+    add_random_balls(2000);
+    sweep.build(balls, balls.size(), boxSize);
+    std::mt19937 generator{3};
+    std::uniform_real_distribution<float> nudge{-0.01, 0.01};
+    float *sortPosition[3]{balls.positionX.data(), balls.positionY.data(), balls.positionZ.data()};
+    for(unsigned int ballIndex{0}; ballIndex < balls.size(); ballIndex++)
+        sortPosition[sweep.get_sort_axis()][ballIndex] += nudge(generator);
+
+    sweep.build(balls, balls.size(), boxSize);
+    sweep.find_pairs(pairs, balls.size());
+    SweepAndPrune freshSweep;
+    std::vector<BallPair> freshPairs;
+    freshSweep.build(balls, balls.size(), boxSize);
+    freshSweep.find_pairs(freshPairs, balls.size());
+
+    EXPECT_GT(sweep.get_last_swap_count(), 0);
+    EXPECT_LT(sweep.get_last_swap_count(), balls.size()/4);
+    ASSERT_EQ(pairs.size(), freshPairs.size());
+    for(unsigned int pairIndex{0}; pairIndex < pairs.size(); pairIndex++)
+    {
+        EXPECT_EQ(pairs[pairIndex].first, freshPairs[pairIndex].first);
+        EXPECT_EQ(pairs[pairIndex].second, freshPairs[pairIndex].second);
+    }
+}
+
+TEST_F(SweepAndPruneTests, WhenBallCountShrinksAndGrows_ExpectOnlyCurrentBallsPaired)
+{
+    add_random_balls(2000);
+    BruteForceBroadphase bruteForce;
+    sweep.build(balls, balls.size(), boxSize);
+
+    sweep.build(balls, 500, boxSize);
+    sweep.find_pairs(pairs, 500);
+    for(const BallPair &pair : pairs)
+        EXPECT_LT(pair.second, 500);
+
+    EXPECT_EQ(find_touching_pairs(sweep, balls.size()), find_touching_pairs(bruteForce, balls.size()));
+}
@@ -0,0 +1,111 @@
+#include "ThreadPool.hpp"
+
+
+ThreadPool::ThreadPool(unsigned int threadCountInput) :
+    threadCount{threadCountInput > 0 ? threadCountInput : 1},
+    queues{new TaskQueue[threadCount]}
+{
+    for(unsigned int queueIndex{1}; queueIndex < threadCount; queueIndex++)
+        workers.push_back(std::thread(&ThreadPool::worker_loop, this, queueIndex));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+    for(std::thread &worker : workers)
+        worker.join();
+}
+
+unsigned int ThreadPool::get_thread_count()
+{
+    return this->threadCount;
+}
+
+void ThreadPool::run(unsigned int taskCount, void (*invoker)(const void *, unsigned int), const void *function)
+{
+    if(taskCount == 0)
+        return;
+    if(threadCount == 1 || taskCount == 1)
+    {
+        for(unsigned int taskIndex{0}; taskIndex < taskCount; taskIndex++)
+            invoker(function, taskIndex);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobInvoker = invoker;
+        jobFunction = function;
+        remainingTasks = taskCount;
+    }
+    for(unsigned int queueIndex{0}; queueIndex < threadCount; queueIndex++)
+    {
+        TaskQueue &queue = queues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.head = 0;
+        queue.tail = queueIndex < taskCount ? (taskCount - queueIndex + threadCount - 1)/threadCount : 0;
+    }
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobGeneration++;
+    }
+    jobAvailable.notify_all();
+
+    while(run_next_task(0))
+    {
+    }
+
+    std::unique_lock<std::mutex> lock(jobMutex);
+    jobFinished.wait(lock, [this]{ return remainingTasks == 0; });
+}
+
+void ThreadPool::worker_loop(unsigned int queueIndex)
+{
+    unsigned long seenGeneration{0};
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobAvailable.wait(lock, [this, seenGeneration]{ return stopping || jobGeneration != seenGeneration; });
+            if(stopping)
+                return;
+            seenGeneration = jobGeneration;
+        }
+        while(run_next_task(queueIndex))
+        {
+        }
+    }
+}
+
+bool ThreadPool::run_next_task(unsigned int queueIndex)
+{
+    unsigned int taskIndex{0};
+    bool found{pop_task(queueIndex, false, taskIndex)};
+    for(unsigned int offset{1}; !found && offset < threadCount; offset++)
+        found = pop_task((queueIndex + offset) % threadCount, true, taskIndex);
+    if(!found)
+        return false;
+
+    jobInvoker(jobFunction, taskIndex);
+    if(remainingTasks.fetch_sub(1) == 1)
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobFinished.notify_all();
+    }
+    return true;
+}
+
+bool ThreadPool::pop_task(unsigned int queueIndex, bool fromHead, unsigned int &taskIndex)
+{
+    TaskQueue &queue = queues[queueIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if(queue.head == queue.tail)
+        return false;
+    unsigned int stride{fromHead ? queue.head++ : --queue.tail};
+    taskIndex = queueIndex + stride*threadCount;
+    return true;
+}
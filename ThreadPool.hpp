@@ -0,0 +1,59 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned int threadCountInput);
+    ~ThreadPool();
+
+    unsigned int get_thread_count();
+
+    template<typename Function>
+    void parallel_for(unsigned int taskCount, const Function &function)
+    {
+        run(taskCount, &invoke<Function>, &function);
+    }
+
+private:
+    // Queue q holds tasks q, q + threadCount, q + 2*threadCount, ... so it
+    // only needs the range of strides still left in it.
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        unsigned int head{0};
+        unsigned int tail{0};
+    };
+
+    template<typename Function>
+    static void invoke(const void *function, unsigned int taskIndex)
+    {
+        (*static_cast<const Function *>(function))(taskIndex);
+    }
+
+    void run(unsigned int taskCount, void (*invoker)(const void *, unsigned int), const void *function);
+    void worker_loop(unsigned int queueIndex);
+    bool run_next_task(unsigned int queueIndex);
+    bool pop_task(unsigned int queueIndex, bool fromHead, unsigned int &taskIndex);
+
+    unsigned int threadCount;
+    std::unique_ptr<TaskQueue[]> queues;
+    std::vector<std::thread> workers;
+    std::mutex jobMutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable jobFinished;
+    unsigned long jobGeneration{0};
+    bool stopping{false};
+    void (*jobInvoker)(const void *, unsigned int){nullptr};
+    const void *jobFunction{nullptr};
+    std::atomic<unsigned int> remainingTasks{0};
+};
+
+#endif
@@ -0,0 +1,45 @@
+#include "gtest/gtest.h"
+#include "ThreadPool.hpp"
+
+#include <atomic>
+#include <vector>
+
+
+TEST(ThreadPoolTests, WhenCreatingPoolWithZeroThreads_ExpectSingleThread)
+{
+    ThreadPool pool(0);
+
+    EXPECT_EQ(pool.get_thread_count(), 1);
+}
+
+TEST(ThreadPoolTests, WhenRunningParallelFor_ExpectEveryTaskRunExactlyOnce)
+{
+    ThreadPool pool(4);
+    std::vector<int> runCounts(1000, 0);
+
+    pool.parallel_for(runCounts.size(), [&runCounts](unsigned int taskIndex){ runCounts[taskIndex]++; });
+
+    for(int runCount : runCounts)
+        EXPECT_EQ(runCount, 1);
+}
+
+TEST(ThreadPoolTests, WhenRunningManyJobsBackToBack_ExpectAllTasksCompleted)
+{
+    ThreadPool pool(8);
+    std::atomic<unsigned int> total{0};
+
+    for(int job{0}; job < 200; job++)
+        pool.parallel_for(37, [&total](unsigned int){ total++; });
+
+    EXPECT_EQ(total, 200*37);
+}
+
+TEST(ThreadPoolTests, WhenRunningNoTasks_ExpectNoCalls)
+{
+    ThreadPool pool(4);
+    bool called{false};
+
+    pool.parallel_for(0, [&called](unsigned int){ called = true; });
+
+    EXPECT_FALSE(called);
+}
@@ -0,0 +1,458 @@
+#include "TrajectoryRecorder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace
+{
+const unsigned char keyframeFlag{1};
+const unsigned char ballIdsFlag{2};
+const unsigned int maxBallId{1u << 26};
+const float quantizationLimit{1073741824.f};
+
+AlignedVector<float> BallStorage::* const recordedArrays[6]
+{
+    &BallStorage::positionX, &BallStorage::positionY, &BallStorage::positionZ,
+    &BallStorage::velocityX, &BallStorage::velocityY, &BallStorage::velocityZ
+};
+
+std::int32_t quantize(float value, float scale)
+{
+    float steps{value/scale};
+    if(!(steps == steps))
+        return 0;
+    return std::int32_t(std::lround(std::max(-quantizationLimit, std::min(steps, quantizationLimit))));
+}
+
+void put_varint(std::vector<unsigned char> &bytes, std::uint64_t value)
+{
+    while(value >= 0x80)
+    {
+        bytes.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    bytes.push_back(value);
+}
+
+bool get_varint(const std::vector<unsigned char> &bytes, std::size_t &offset, std::uint64_t &value)
+{
+    value = 0;
+    for(unsigned int shift{0}; shift < 64 && offset < bytes.size(); shift += 7)
+    {
+        unsigned char byte{bytes[offset++]};
+        value |= std::uint64_t(byte & 0x7F) << shift;
+        if(!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// Nonzero deltas are zigzag varints; a zero is followed by the length of
+// the run of zeros it starts, which is what sleeping balls turn into.
+void put_deltas(std::vector<unsigned char> &bytes, const std::vector<std::int32_t> &deltas, unsigned int count)
+{
+    unsigned int index{0};
+    while(index < count)
+    {
+        if(deltas[index] == 0)
+        {
+            unsigned int runEnd{index + 1};
+            while(runEnd < count && deltas[runEnd] == 0)
+                runEnd++;
+            put_varint(bytes, 0);
+            put_varint(bytes, runEnd - index - 1);
+            index = runEnd;
+        }
+        else
+        {
+            std::uint32_t delta{std::uint32_t(deltas[index++])};
+            put_varint(bytes, (delta << 1) ^ (0u - (delta >> 31)));
+        }
+    }
+}
+
+bool get_deltas(const std::vector<unsigned char> &bytes, std::size_t &offset, std::vector<std::int32_t> &deltas, unsigned int count)
+{
+    unsigned int index{0};
+    std::uint64_t value;
+    while(index < count)
+    {
+        if(!get_varint(bytes, offset, value))
+            return false;
+        if(value == 0)
+        {
+            if(!get_varint(bytes, offset, value) || value >= count - index)
+                return false;
+            std::fill(deltas.begin() + index, deltas.begin() + index + value + 1, 0);
+            index += value + 1;
+        }
+        else
+        {
+            std::uint32_t zigzag(value);
+            deltas[index++] = std::int32_t((zigzag >> 1) ^ (0u - (zigzag & 1)));
+        }
+    }
+    return true;
+}
+}
+
+TrajectoryRecorder::TrajectoryRecorder(unsigned int stepIntervalInput, unsigned int keyframeIntervalInput, unsigned int queueCapacityInput)
+    : stepInterval{std::max(stepIntervalInput, 1u)}, keyframeInterval{std::max(keyframeIntervalInput, 1u)}, queueCapacity{std::max(queueCapacityInput, 1u)}
+{
+}
+
+TrajectoryRecorder::~TrajectoryRecorder()
+{
+    close();
+}
+
+// Every frame buffer is sized for maxBallCount up front, so recording a
+// step never allocates unless the simulator grows past it.
+bool TrajectoryRecorder::open(const std::string &path, float boxBoundSize, unsigned int maxBallCount, float velocityRange)
+{
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if(!file)
+        return false;
+
+    trajectoryfile::Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, trajectoryfile::magic, sizeof(header.magic));
+    header.version = trajectoryfile::currentVersion;
+    header.byteOrderMark = trajectoryfile::byteOrderMark;
+    header.positionScale = boxBoundSize/trajectoryfile::quantizationSteps;
+    header.velocityScale = velocityRange/trajectoryfile::quantizationSteps;
+    header.stepInterval = stepInterval;
+    header.keyframeInterval = keyframeInterval;
+    if(std::fwrite(&header, sizeof(header), 1, file) != 1)
+    {
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    for(unsigned int component{0}; component < 6; component++)
+    {
+        scales[component] = component < 3 ? header.positionScale : header.velocityScale;
+        slotValues[component].clear();
+    }
+    queue.resize(queueCapacity);
+    for(RawFrame &frame : queue)
+    {
+        frame.ballIds.reserve(maxBallCount);
+        for(std::vector<float> &values : frame.values)
+            values.reserve(maxBallCount);
+    }
+    queueHead = 0;
+    queueCount = 0;
+    stopping = false;
+    writeFailed = false;
+    framesSinceKeyframe = 0;
+    chunkFrameCount = 0;
+    chunk.clear();
+    previousBallIds.clear();
+    recordedFrameCount = 0;
+    droppedFrameCount = 0;
+    bytesWritten = sizeof(header);
+    compressionThread = std::thread(&TrajectoryRecorder::compression_loop, this);
+    return true;
+}
+
+// Encodes everything still queued, writes the last chunk and closes the
+// file. Returns false if any write failed along the way.
+bool TrajectoryRecorder::close()
+{
+    if(!file)
+        return false;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    frameQueued.notify_one();
+    compressionThread.join();
+    flush_chunk();
+    writeFailed = std::fclose(file) != 0 || writeFailed;
+    file = nullptr;
+    return !writeFailed;
+}
+
+// Called by the physics thread after a step. Only copies the recorded
+// arrays into a free frame; a full queue costs the frame, never a wait.
+void TrajectoryRecorder::record(const BallStorage &balls, const unsigned int *ballIds, unsigned int ballCount, unsigned long step)
+{
+    if(!file || step % stepInterval != 0)
+        return;
+    unsigned int frameIndex;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if(queueCount == queueCapacity)
+        {
+            droppedFrameCount++;
+            return;
+        }
+        frameIndex = (queueHead + queueCount) % queueCapacity;
+    }
+
+    RawFrame &frame = queue[frameIndex];
+    frame.step = step;
+    frame.ballCount = ballCount;
+    frame.ballIds.assign(ballIds, ballIds + ballCount);
+    for(unsigned int component{0}; component < 6; component++)
+    {
+        const float *values{(balls.*recordedArrays[component]).data()};
+        frame.values[component].assign(values, values + ballCount);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queueCount++;
+    }
+    frameQueued.notify_one();
+    recordedFrameCount++;
+}
+
+bool TrajectoryRecorder::is_open()
+{
+    return file != nullptr;
+}
+
+unsigned int TrajectoryRecorder::get_step_interval()
+{
+    return stepInterval;
+}
+
+unsigned int TrajectoryRecorder::get_keyframe_interval()
+{
+    return keyframeInterval;
+}
+
+unsigned long TrajectoryRecorder::get_recorded_frame_count()
+{
+    return recordedFrameCount;
+}
+
+unsigned long TrajectoryRecorder::get_dropped_frame_count()
+{
+    return droppedFrameCount;
+}
+
+unsigned long TrajectoryRecorder::get_bytes_written()
+{
+    return bytesWritten;
+}
+
+void TrajectoryRecorder::compression_loop()
+{
+    while(true)
+    {
+        unsigned int frameIndex;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            frameQueued.wait(lock, [this]{ return queueCount > 0 || stopping; });
+            if(queueCount == 0)
+                return;
+            frameIndex = queueHead;
+        }
+        encode_frame(queue[frameIndex]);
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queueHead = (queueHead + 1) % queueCapacity;
+        queueCount--;
+    }
+}
+
+// A frame is its step, ball count and flags, the ball ids if they differ
+// from the previous frame's, then one delta stream per component. Deltas
+// are taken per ball id against the last quantized value, so they never
+// accumulate rounding error; a keyframe takes them against zero.
+void TrajectoryRecorder::encode_frame(const RawFrame &frame)
+{
+    bool keyframe{framesSinceKeyframe == 0};
+    if(keyframe)
+    {
+        flush_chunk();
+        for(std::vector<std::int32_t> &values : slotValues)
+            std::fill(values.begin(), values.end(), 0);
+    }
+    bool idsChanged{keyframe || frame.ballIds != previousBallIds};
+    put_varint(chunk, frame.step);
+    put_varint(chunk, frame.ballCount);
+    chunk.push_back((keyframe ? keyframeFlag : 0) | (idsChanged ? ballIdsFlag : 0));
+    if(idsChanged)
+    {
+        previousBallIds = frame.ballIds;
+        unsigned int idCount{0};
+        for(unsigned int ballId : frame.ballIds)
+        {
+            put_varint(chunk, ballId);
+            idCount = std::max(idCount, ballId + 1);
+        }
+        if(idCount > slotValues[0].size())
+            for(std::vector<std::int32_t> &values : slotValues)
+                values.resize(idCount, 0);
+    }
+
+    deltas.resize(frame.ballCount);
+    for(unsigned int component{0}; component < 6; component++)
+    {
+        std::vector<std::int32_t> &values = slotValues[component];
+        for(unsigned int index{0}; index < frame.ballCount; index++)
+        {
+            std::int32_t value{quantize(frame.values[component][index], scales[component])};
+            std::int32_t &previous = values[frame.ballIds[index]];
+            deltas[index] = std::int32_t(std::uint32_t(value) - std::uint32_t(previous));
+            previous = value;
+        }
+        put_deltas(chunk, deltas, frame.ballCount);
+    }
+    chunkFrameCount++;
+    framesSinceKeyframe = (framesSinceKeyframe + 1) % keyframeInterval;
+}
+
+bool TrajectoryRecorder::flush_chunk()
+{
+    if(chunkFrameCount == 0)
+        return true;
+    trajectoryfile::ChunkHeader chunkHeader{trajectoryfile::chunkMagic, chunkFrameCount, chunk.size()};
+    if(std::fwrite(&chunkHeader, sizeof(chunkHeader), 1, file) != 1 || std::fwrite(chunk.data(), 1, chunk.size(), file) != chunk.size())
+        writeFailed = true;
+    bytesWritten += sizeof(chunkHeader) + chunk.size();
+    chunk.clear();
+    chunkFrameCount = 0;
+    return !writeFailed;
+}
+
+TrajectoryReader::~TrajectoryReader()
+{
+    close();
+}
+
+bool TrajectoryReader::open(const std::string &path)
+{
+    close();
+    file = std::fopen(path.c_str(), "rb");
+    if(!file)
+        return false;
+    long fileSize{-1};
+    if(std::fseek(file, 0, SEEK_END) == 0)
+        fileSize = std::ftell(file);
+    bool valid{fileSize >= long(sizeof(header)) && std::fseek(file, 0, SEEK_SET) == 0 && std::fread(&header, sizeof(header), 1, file) == 1};
+    valid = valid && std::memcmp(header.magic, trajectoryfile::magic, sizeof(header.magic)) == 0;
+    valid = valid && header.version == trajectoryfile::currentVersion && header.byteOrderMark == trajectoryfile::byteOrderMark;
+    valid = valid && header.positionScale > 0 && header.velocityScale > 0;
+    if(!valid)
+    {
+        close();
+        return false;
+    }
+    bytesLeft = fileSize - sizeof(header);
+    chunkFramesLeft = 0;
+    ballIds.clear();
+    for(std::vector<std::int32_t> &values : slotValues)
+        values.clear();
+    return true;
+}
+
+void TrajectoryReader::close()
+{
+    if(file)
+        std::fclose(file);
+    file = nullptr;
+}
+
+// Decodes the next recorded frame. Returns false at the end of the file or
+// on anything malformed.
+bool TrajectoryReader::read_frame(TrajectoryFrame &frame)
+{
+    if(!file || (chunkFramesLeft == 0 && !read_chunk()))
+        return false;
+    chunkFramesLeft--;
+
+    std::uint64_t step, ballCount;
+    if(!get_varint(chunk, chunkOffset, step) || !get_varint(chunk, chunkOffset, ballCount) || chunkOffset >= chunk.size())
+        return false;
+    unsigned char flags{chunk[chunkOffset++]};
+    bool keyframe{(flags & keyframeFlag) != 0};
+    if(keyframe)
+        for(std::vector<std::int32_t> &values : slotValues)
+            std::fill(values.begin(), values.end(), 0);
+    if(flags & ballIdsFlag)
+    {
+        if(ballCount > chunk.size() - chunkOffset)
+            return false;
+        ballIds.resize(ballCount);
+        unsigned int idCount{0};
+        for(unsigned int &ballId : ballIds)
+        {
+            std::uint64_t value;
+            if(!get_varint(chunk, chunkOffset, value) || value >= maxBallId)
+                return false;
+            ballId = value;
+            idCount = std::max(idCount, ballId + 1);
+        }
+        if(idCount > slotValues[0].size())
+            for(std::vector<std::int32_t> &values : slotValues)
+                values.resize(idCount, 0);
+    }
+    else if(keyframe || ballCount != ballIds.size())
+        return false;
+
+    frame.step = step;
+    frame.keyframe = keyframe;
+    frame.ballIds = ballIds;
+    frame.positions.resize(ballCount);
+    frame.velocities.resize(ballCount);
+    deltas.resize(ballCount);
+    for(unsigned int component{0}; component < 6; component++)
+    {
+        if(!get_deltas(chunk, chunkOffset, deltas, ballCount))
+            return false;
+        std::vector<std::int32_t> &values = slotValues[component];
+        float scale{component < 3 ? header.positionScale : header.velocityScale};
+        std::vector<Eigen::Vector3f> &vectors = component < 3 ? frame.positions : frame.velocities;
+        for(unsigned int index{0}; index < ballCount; index++)
+        {
+            std::int32_t &value = values[ballIds[index]];
+            value = std::int32_t(std::uint32_t(value) + std::uint32_t(deltas[index]));
+            vectors[index][component % 3] = value*scale;
+        }
+    }
+    return true;
+}
+
+unsigned int TrajectoryReader::get_step_interval()
+{
+    return header.stepInterval;
+}
+
+unsigned int TrajectoryReader::get_keyframe_interval()
+{
+    return header.keyframeInterval;
+}
+
+float TrajectoryReader::get_position_scale()
+{
+    return header.positionScale;
+}
+
+float TrajectoryReader::get_velocity_scale()
+{
+    return header.velocityScale;
+}
+
+bool TrajectoryReader::read_chunk()
+{
+    trajectoryfile::ChunkHeader chunkHeader;
+    if(bytesLeft < sizeof(chunkHeader) || std::fread(&chunkHeader, sizeof(chunkHeader), 1, file) != 1)
+        return false;
+    bytesLeft -= sizeof(chunkHeader);
+    if(chunkHeader.chunkMagic != trajectoryfile::chunkMagic || chunkHeader.frameCount == 0 || chunkHeader.payloadSize > bytesLeft)
+        return false;
+    chunk.resize(chunkHeader.payloadSize);
+    if(std::fread(chunk.data(), 1, chunk.size(), file) != chunk.size())
+        return false;
+    bytesLeft -= chunk.size();
+    chunkOffset = 0;
+    chunkFramesLeft = chunkHeader.frameCount;
+    return true;
+}
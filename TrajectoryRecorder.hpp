@@ -0,0 +1,148 @@
+#ifndef TRAJECTORY_RECORDER_HPP
+#define TRAJECTORY_RECORDER_HPP
+
+#include "BallStorage.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <eigen3/Eigen/Dense>
+
+// A trajectory file is a header followed by chunks. Every chunk starts with
+// a keyframe holding absolute values, so chunks decode on their own; the
+// frames after it hold per-ball deltas from the previous recorded frame.
+// Positions are quantized to boxBoundSize/32768 and velocities to
+// velocityRange/32768, and each quantized component is stored as a zigzag
+// varint with runs of zeros collapsed, so resting balls cost next to nothing.
+namespace trajectoryfile
+{
+const char magic[8]{'B', 'F', 'T', 'R', 'A', 'C', 'E', '\0'};
+const std::uint32_t chunkMagic{0x4B435254};
+const std::uint32_t currentVersion{1};
+const std::uint32_t byteOrderMark{0x01020304};
+const float quantizationSteps{32768};
+
+struct Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrderMark;
+    float positionScale;
+    float velocityScale;
+    std::uint32_t stepInterval;
+    std::uint32_t keyframeInterval;
+};
+
+struct ChunkHeader
+{
+    std::uint32_t chunkMagic;
+    std::uint32_t frameCount;
+    std::uint64_t payloadSize;
+};
+}
+
+struct TrajectoryFrame
+{
+    unsigned long step{0};
+    bool keyframe{false};
+    std::vector<unsigned int> ballIds;
+    std::vector<Eigen::Vector3f> positions;
+    std::vector<Eigen::Vector3f> velocities;
+};
+
+// record() only copies the step into a preallocated frame ring; encoding
+// and disk writes happen on the recorder's own thread. When the ring is
+// full the step is dropped and counted instead of waiting.
+class TrajectoryRecorder
+{
+public:
+    TrajectoryRecorder(unsigned int stepIntervalInput=1, unsigned int keyframeIntervalInput=120, unsigned int queueCapacityInput=8);
+    ~TrajectoryRecorder();
+    TrajectoryRecorder(const TrajectoryRecorder &) = delete;
+    TrajectoryRecorder& operator=(const TrajectoryRecorder &) = delete;
+
+    bool open(const std::string &path, float boxBoundSize, unsigned int maxBallCount, float velocityRange=64);
+    bool close();
+    void record(const BallStorage &balls, const unsigned int *ballIds, unsigned int ballCount, unsigned long step);
+
+    bool is_open();
+    unsigned int get_step_interval();
+    unsigned int get_keyframe_interval();
+    unsigned long get_recorded_frame_count();
+    unsigned long get_dropped_frame_count();
+    unsigned long get_bytes_written();
+
+protected:
+    struct RawFrame
+    {
+        unsigned long step;
+        unsigned int ballCount;
+        std::vector<unsigned int> ballIds;
+        std::vector<float> values[6];
+    };
+
+    void compression_loop();
+    void encode_frame(const RawFrame &frame);
+    bool flush_chunk();
+
+    unsigned int stepInterval{1};
+    unsigned int keyframeInterval{120};
+    unsigned int queueCapacity{8};
+    std::vector<RawFrame> queue;
+    unsigned int queueHead{0};
+    unsigned int queueCount{0};
+    std::mutex queueMutex;
+    std::condition_variable frameQueued;
+    bool stopping{false};
+    std::thread compressionThread;
+    std::atomic<unsigned long> recordedFrameCount{0};
+    std::atomic<unsigned long> droppedFrameCount{0};
+
+    std::FILE *file{nullptr};
+    bool writeFailed{false};
+    float scales[6];
+    unsigned int framesSinceKeyframe{0};
+    unsigned int chunkFrameCount{0};
+    std::vector<unsigned char> chunk;
+    std::vector<unsigned int> previousBallIds;
+    std::vector<std::int32_t> slotValues[6];
+    std::vector<std::int32_t> deltas;
+    std::atomic<unsigned long> bytesWritten{0};
+};
+
+class TrajectoryReader
+{
+public:
+    TrajectoryReader() {}
+    ~TrajectoryReader();
+    TrajectoryReader(const TrajectoryReader &) = delete;
+    TrajectoryReader& operator=(const TrajectoryReader &) = delete;
+
+    bool open(const std::string &path);
+    void close();
+    bool read_frame(TrajectoryFrame &frame);
+
+    unsigned int get_step_interval();
+    unsigned int get_keyframe_interval();
+    float get_position_scale();
+    float get_velocity_scale();
+
+protected:
+    bool read_chunk();
+
+    std::FILE *file{nullptr};
+    std::uint64_t bytesLeft{0};
+    trajectoryfile::Header header;
+    std::vector<unsigned char> chunk;
+    std::size_t chunkOffset{0};
+    unsigned int chunkFramesLeft{0};
+    std::vector<unsigned int> ballIds;
+    std::vector<std::int32_t> slotValues[6];
+    std::vector<std::int32_t> deltas;
+};
+
+#endif
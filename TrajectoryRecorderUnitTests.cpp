@@ -0,0 +1,210 @@
+#include "gtest/gtest.h"
+#include "BallPhysics.hpp"
+#include "TrajectoryRecorder.hpp"
+#include <cstdio>
+#include <fstream>
+
+
+class TrajectoryRecorderTests : public ::testing::Test
+{
+protected:
+    void SetUp();
+    void TearDown();
+    void fill_fountain(BallPhysics &fountain);
+    void fill_pile(BallPhysics &pile);
+
+    std::string path;
+    float stepTime{1.0/120};
+};
+
+void TrajectoryRecorderTests::SetUp()
+{
+    path = ::testing::TempDir() + "TrajectoryRecorderTests_" + ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".trajectory";
+}
+
+void TrajectoryRecorderTests::TearDown()
+{
+    std::remove(path.c_str());
+}
+
+void TrajectoryRecorderTests::fill_fountain(BallPhysics &fountain)
+{
+    Emitter nozzle(Eigen::Vector3f{0, 0, 0.5}, Eigen::Vector3f{0, 0, 1}, 15, 400);
+    nozzle.set_spread_angle(0.3);
+    fountain.add_emitter(nozzle);
+}
+
+void TrajectoryRecorderTests::fill_pile(BallPhysics &pile)
+{
+    pile.set_new_ball_velocity(Eigen::Vector3f{0, 0, 0});
+    for(unsigned int ballIndex{0}; ballIndex < pile.get_max_ball_count(); ballIndex++)
+    {
+        pile.set_new_ball_position(Eigen::Vector3f{float(ballIndex%10) - 5, float((ballIndex/10)%10) - 5, 0.5f + ballIndex/100});
+        pile.add_ball();
+    }
+}
+
+TEST_F(TrajectoryRecorderTests, WhenRecordingFountain_ExpectFramesWithinQuantizationStep)
+{
+    BallPhysics fountain(10, 1.2, -9.81, 300);
+    fill_fountain(fountain);
+    TrajectoryRecorder recorder(1, 40, 200);
+    ASSERT_TRUE(recorder.open(path, fountain.get_box_size(), fountain.get_max_ball_count()));
+    fountain.set_trajectory_recorder(&recorder);
+    std::vector<TrajectoryFrame> expectedFrames;
+    for(int step{0}; step < 150; step++)
+    {
+        fountain.update(stepTime);
+        TrajectoryFrame expected;
+        expected.step = fountain.get_step_count();
+        for(unsigned int index{0}; index < fountain.get_ball_count(); index++)
+        {
+            expected.ballIds.push_back(fountain.get_ball_handle(index).slot);
+            expected.positions.push_back(fountain.get_ball_ptr(index)->position);
+            expected.velocities.push_back(fountain.get_ball_ptr(index)->velocity);
+        }
+        expectedFrames.push_back(expected);
+    }
+    ASSERT_TRUE(recorder.close());
+    ASSERT_EQ(recorder.get_dropped_frame_count(), 0);
+
+    TrajectoryReader reader;
+    ASSERT_TRUE(reader.open(path));
+    float positionTolerance{reader.get_position_scale()*0.51f};
+    float velocityTolerance{reader.get_velocity_scale()*0.51f};
+    TrajectoryFrame frame;
+    for(unsigned int frameIndex{0}; frameIndex < expectedFrames.size(); frameIndex++)
+    {
+        const TrajectoryFrame &expected = expectedFrames[frameIndex];
+        ASSERT_TRUE(reader.read_frame(frame));
+        EXPECT_EQ(frame.step, expected.step);
+        EXPECT_EQ(frame.keyframe, frameIndex % 40 == 0);
+        ASSERT_EQ(frame.ballIds, expected.ballIds);
+        for(unsigned int index{0}; index < expected.ballIds.size(); index++)
+            for(int axis{0}; axis < 3; axis++)
+            {
+                ASSERT_NEAR(frame.positions[index][axis], expected.positions[index][axis], positionTolerance);
+                ASSERT_NEAR(frame.velocities[index][axis], expected.velocities[index][axis], velocityTolerance);
+            }
+    }
+    EXPECT_FALSE(reader.read_frame(frame));
+}
+
+TEST_F(TrajectoryRecorderTests, WhenRecordingEveryNthStep_ExpectOnlyThoseStepsInFile)
+{
+    BallPhysics fountain(10, 0, -9.81, 100);
+    fill_fountain(fountain);
+    TrajectoryRecorder recorder(4, 3, 64);
+    ASSERT_TRUE(recorder.open(path, fountain.get_box_size(), fountain.get_max_ball_count()));
+    fountain.set_trajectory_recorder(&recorder);
+    for(int step{0}; step < 40; step++)
+        fountain.update(stepTime);
+    fountain.set_trajectory_recorder(nullptr);
+    fountain.update(stepTime);
+    ASSERT_TRUE(recorder.close());
+
+    TrajectoryReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_EQ(reader.get_step_interval(), 4);
+    EXPECT_EQ(reader.get_keyframe_interval(), 3);
+    TrajectoryFrame frame;
+    unsigned long frameCount{0};
+    while(reader.read_frame(frame))
+    {
+        EXPECT_EQ(frame.step, 4*(frameCount + 1));
+        EXPECT_EQ(frame.keyframe, frameCount % 3 == 0);
+        frameCount++;
+    }
+    EXPECT_EQ(frameCount, 10);
+    EXPECT_EQ(recorder.get_recorded_frame_count(), 10);
+}
+
+TEST_F(TrajectoryRecorderTests, WhenRecordingMovingFountain_ExpectSmallFractionOfRawBallSize)
+{
+    BallPhysics fountain(10, 1.2, -9.81, 2000);
+    fill_fountain(fountain);
+    for(int step{0}; step < 600; step++)
+        fountain.update(stepTime);
+    TrajectoryRecorder recorder(1, 120, 256);
+    ASSERT_TRUE(recorder.open(path, fountain.get_box_size(), fountain.get_max_ball_count()));
+    fountain.set_trajectory_recorder(&recorder);
+    for(int step{0}; step < 240; step++)
+        fountain.update(stepTime);
+    ASSERT_TRUE(recorder.close());
+
+    ASSERT_EQ(recorder.get_dropped_frame_count(), 0);
+    double rawBytes{double(sizeof(Ball))*fountain.get_ball_count()*recorder.get_recorded_frame_count()};
+    EXPECT_LT(recorder.get_bytes_written(), rawBytes/4);
+}
+
+TEST_F(TrajectoryRecorderTests, WhenRecordingSleepingPile_ExpectAlmostNothingWrittenBetweenKeyframes)
+{
+    BallPhysics pile(10, 0, -9.81, 400);
+    fill_pile(pile);
+    for(int step{0}; step < 600; step++)
+        pile.update(stepTime);
+    ASSERT_EQ(pile.get_awake_ball_count(), 0);
+    TrajectoryRecorder recorder(1, 120, 256);
+    ASSERT_TRUE(recorder.open(path, pile.get_box_size(), pile.get_max_ball_count()));
+    pile.set_trajectory_recorder(&recorder);
+    for(int step{0}; step < 240; step++)
+        pile.update(stepTime);
+    ASSERT_TRUE(recorder.close());
+
+    double rawBytes{double(sizeof(Ball))*pile.get_ball_count()*recorder.get_recorded_frame_count()};
+    EXPECT_LT(recorder.get_bytes_written(), rawBytes/50);
+}
+
+TEST_F(TrajectoryRecorderTests, WhenRecorderNotOpen_ExpectNothingRecorded)
+{
+    BallPhysics fountain(10, 0, -9.81, 100);
+    fill_fountain(fountain);
+    TrajectoryRecorder recorder;
+    fountain.set_trajectory_recorder(&recorder);
+    for(int step{0}; step < 20; step++)
+        fountain.update(stepTime);
+
+    EXPECT_FALSE(recorder.is_open());
+    EXPECT_FALSE(recorder.close());
+    EXPECT_EQ(recorder.get_recorded_frame_count(), 0);
+}
+
+TEST_F(TrajectoryRecorderTests, WhenReadingFileWithWrongMagic_ExpectFailure)
+{
+    TrajectoryRecorder recorder;
+    ASSERT_TRUE(recorder.open(path, 10, 10));
+    ASSERT_TRUE(recorder.close());
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.write("NOTTRACE", 8);
+    file.close();
+
+    TrajectoryReader reader;
+    EXPECT_FALSE(reader.open(path));
+    EXPECT_FALSE(reader.open(path + ".missing"));
+}
+
+TEST_F(TrajectoryRecorderTests, WhenReadingTruncatedFile_ExpectFramesBeforeCutOnly)
+{
+    BallPhysics fountain(10, 0, -9.81, 100);
+    fill_fountain(fountain);
+    TrajectoryRecorder recorder(1, 10, 64);
+    ASSERT_TRUE(recorder.open(path, fountain.get_box_size(), fountain.get_max_ball_count()));
+    fountain.set_trajectory_recorder(&recorder);
+    for(int step{0}; step < 25; step++)
+        fountain.update(stepTime);
+    ASSERT_TRUE(recorder.close());
+    std::ifstream input(path, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    input.close();
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output.write(contents.data(), contents.size() - 10);
+    output.close();
+
+    TrajectoryReader reader;
+    ASSERT_TRUE(reader.open(path));
+    TrajectoryFrame frame;
+    unsigned long frameCount{0};
+    while(reader.read_frame(frame))
+        frameCount++;
+    EXPECT_EQ(frameCount, 20);
+}